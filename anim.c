@@ -0,0 +1,98 @@
+#include "anim.h"
+
+// Basic Charakter Actions.png: 48x48 cells, two frames per row, four rows
+// per tool facing down, up, right, left
+#define ACTION_CELL (48.0f)
+#define ACTION_FRAME(col, row) { (col) * ACTION_CELL, (row) * ACTION_CELL, ACTION_CELL, ACTION_CELL }
+#define TOOL_CLIP(tool, row)                                                        \
+  {                                                                                 \
+    .texture = PLAYER_ACTIONS,                                                      \
+    .frames = { ACTION_FRAME(0, (tool) * 4 + (row)), ACTION_FRAME(1, (tool) * 4 + (row)) }, \
+    .frame_count = 2,                                                               \
+    .frames_per_second = 6.0f,                                                      \
+  }
+
+#define TOOL_CLIPS(tool, first)                  \
+  [first + FACING_DOWN] = TOOL_CLIP(tool, 0),    \
+  [first + FACING_UP] = TOOL_CLIP(tool, 1),      \
+  [first + FACING_LEFT] = TOOL_CLIP(tool, 3),    \
+  [first + FACING_RIGHT] = TOOL_CLIP(tool, 2)
+
+const AnimClip AnimClips[CLIP_COUNT] = {
+  [CLIP_NONE] = { .frame_count = 1, .loop = true },
+
+  // Player.png: 3 frames of 32x32, the first one doubles as the idle pose
+  [CLIP_PLAYER_IDLE] = {
+    .texture = PLAYER,
+    .frames = { { 0.0f, 0.0f, 32.0f, 32.0f } },
+    .frame_count = 1,
+    .loop = true,
+    .flip_left = true,
+  },
+  [CLIP_PLAYER_WALK] = {
+    .texture = PLAYER,
+    .frames = { { 0.0f, 0.0f, 32.0f, 32.0f }, { 32.0f, 0.0f, 32.0f, 32.0f }, { 64.0f, 0.0f, 32.0f, 32.0f } },
+    .frame_count = 3,
+    .frames_per_second = 10.0f,
+    .loop = true,
+    .speed_scaled = true,
+    .flip_left = true,
+  },
+
+  TOOL_CLIPS(TOOL_HOE, CLIP_PLAYER_HOE_DOWN),
+  TOOL_CLIPS(TOOL_AXE, CLIP_PLAYER_AXE_DOWN),
+  TOOL_CLIPS(TOOL_WATER, CLIP_PLAYER_WATER_DOWN),
+
+  // Chicken sheet: 16x16, pecking on the top row, walking on the bottom one
+  [CLIP_CHICKEN_IDLE] = {
+    .texture = CHICKEN,
+    .frames = { { 0.0f, 0.0f, 16.0f, 16.0f }, { 16.0f, 0.0f, 16.0f, 16.0f } },
+    .frame_count = 2,
+    .frames_per_second = 2.0f,
+    .loop = true,
+    .flip_left = true,
+  },
+  [CLIP_CHICKEN_WALK] = {
+    .texture = CHICKEN,
+    .frames = {
+      { 0.0f, 16.0f, 16.0f, 16.0f }, { 16.0f, 16.0f, 16.0f, 16.0f },
+      { 32.0f, 16.0f, 16.0f, 16.0f }, { 48.0f, 16.0f, 16.0f, 16.0f },
+    },
+    .frame_count = 4,
+    .frames_per_second = 10.0f,
+    .loop = true,
+    .speed_scaled = true,
+    .flip_left = true,
+  },
+
+  // Cow sheet: 32x32, walking on the top row, chewing on the bottom one
+  [CLIP_COW_IDLE] = {
+    .texture = COW,
+    .frames = { { 0.0f, 32.0f, 32.0f, 32.0f }, { 32.0f, 32.0f, 32.0f, 32.0f } },
+    .frame_count = 2,
+    .frames_per_second = 1.5f,
+    .loop = true,
+    .flip_left = true,
+  },
+  [CLIP_COW_WALK] = {
+    .texture = COW,
+    .frames = { { 0.0f, 0.0f, 32.0f, 32.0f }, { 32.0f, 0.0f, 32.0f, 32.0f }, { 64.0f, 0.0f, 32.0f, 32.0f } },
+    .frame_count = 3,
+    .frames_per_second = 10.0f,
+    .loop = true,
+    .speed_scaled = true,
+    .flip_left = true,
+  },
+};
+
+const AnimClipId IdleClips[TEXTURE_TYPE_COUNT] = {
+  [PLAYER] = CLIP_PLAYER_IDLE,
+  [CHICKEN] = CLIP_CHICKEN_IDLE,
+  [COW] = CLIP_COW_IDLE,
+};
+
+const AnimClipId WalkClips[TEXTURE_TYPE_COUNT] = {
+  [PLAYER] = CLIP_PLAYER_WALK,
+  [CHICKEN] = CLIP_CHICKEN_WALK,
+  [COW] = CLIP_COW_WALK,
+};
@@ -0,0 +1,71 @@
+#ifndef ANIM_H_
+#define ANIM_H_
+
+#include "external/raylib-5.5/src/raylib.h"
+#include "game.h"
+#include <stdbool.h>
+
+#define MAX_CLIP_FRAMES (4)
+
+// Every animation an entity can play. Frame rects are laid out once in a
+// table, so advancing a sprite is a multiply and a lookup.
+typedef enum AnimClipId {
+  CLIP_NONE,  // a single blank frame, never advances
+  CLIP_PLAYER_IDLE,
+  CLIP_PLAYER_WALK,
+  // Tool swings, one clip per tool and facing in ToolAction x Facing order
+  CLIP_PLAYER_HOE_DOWN,
+  CLIP_PLAYER_HOE_UP,
+  CLIP_PLAYER_HOE_LEFT,
+  CLIP_PLAYER_HOE_RIGHT,
+  CLIP_PLAYER_AXE_DOWN,
+  CLIP_PLAYER_AXE_UP,
+  CLIP_PLAYER_AXE_LEFT,
+  CLIP_PLAYER_AXE_RIGHT,
+  CLIP_PLAYER_WATER_DOWN,
+  CLIP_PLAYER_WATER_UP,
+  CLIP_PLAYER_WATER_LEFT,
+  CLIP_PLAYER_WATER_RIGHT,
+  CLIP_CHICKEN_IDLE,
+  CLIP_CHICKEN_WALK,
+  CLIP_COW_IDLE,
+  CLIP_COW_WALK,
+  CLIP_COUNT
+} AnimClipId;
+
+typedef enum Facing {
+  FACING_DOWN,
+  FACING_UP,
+  FACING_LEFT,
+  FACING_RIGHT,
+  FACING_COUNT
+} Facing;
+
+typedef enum ToolAction {
+  TOOL_HOE,
+  TOOL_AXE,
+  TOOL_WATER,
+  TOOL_ACTION_COUNT
+} ToolAction;
+
+typedef struct AnimClip {
+  TextureType texture;
+  Rectangle frames[MAX_CLIP_FRAMES];
+  int frame_count;
+  float frames_per_second;
+  bool loop;          // otherwise plays once and hands back to idle/walk
+  bool speed_scaled;  // plays at frames_per_second at top speed, slower below it
+  bool flip_left;     // mirrored when facing left (the sheet has no left row)
+} AnimClip;
+
+extern const AnimClip AnimClips[CLIP_COUNT];
+
+// What an entity drawn from a sheet plays when standing and when moving
+extern const AnimClipId IdleClips[TEXTURE_TYPE_COUNT];
+extern const AnimClipId WalkClips[TEXTURE_TYPE_COUNT];
+
+static inline AnimClipId GetToolClip(ToolAction action, Facing facing) {
+  return CLIP_PLAYER_HOE_DOWN + action * FACING_COUNT + facing;
+}
+
+#endif // ANIM_H_
@@ -0,0 +1,104 @@
+#include "assetpack.h"
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static bool ValidatePack(const AssetPack *pack) {
+  if (pack->size < sizeof(PackHeader)) return false;
+
+  const PackHeader *header = (const PackHeader *)pack->data;
+  if (header->magic != PACK_MAGIC || header->version != PACK_VERSION) return false;
+
+  size_t index_end = sizeof(PackHeader) + (size_t)header->entry_count * sizeof(PackEntry);
+  if (index_end > pack->size) return false;
+
+  const PackEntry *entries = (const PackEntry *)(pack->data + sizeof(PackHeader));
+  for (uint32_t i = 0; i < header->entry_count; i++) {
+    const PackEntry *entry = &entries[i];
+    if (memchr(entry->path, '\0', PACK_PATH_SIZE) == NULL) return false;
+    if (entry->offset < index_end || entry->offset > pack->size) return false;
+    if (entry->size > pack->size - entry->offset) return false;
+    // The upload reads as many bytes as the format and size imply, whatever
+    // entry->size says, so they have to agree
+    if (entry->width <= 0 || entry->height <= 0) return false;
+    if (entry->format != PACK_PIXEL_FORMAT || entry->mipmaps != 1) return false;
+    if (entry->size != (uint64_t)entry->width * (uint64_t)entry->height * PACK_PIXEL_SIZE) return false;
+    if (i > 0 && strcmp(entries[i - 1].path, entry->path) >= 0) return false;
+  }
+  return true;
+}
+
+static bool LoadPackIndex(AssetPack *pack) {
+  if (!ValidatePack(pack)) {
+    CloseAssetPack(pack);
+    return false;
+  }
+
+  const PackHeader *header = (const PackHeader *)pack->data;
+  pack->entries = (const PackEntry *)(pack->data + sizeof(PackHeader));
+  pack->entry_count = header->entry_count;
+  return true;
+}
+
+bool OpenAssetPack(AssetPack *pack, const char *path) {
+  *pack = (AssetPack) {0};
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return false;
+  }
+
+  void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps the file alive on its own
+  close(fd);
+  if (data == MAP_FAILED) return false;
+
+  pack->data = data;
+  pack->size = st.st_size;
+  pack->mapped = true;
+  return LoadPackIndex(pack);
+}
+
+void CloseAssetPack(AssetPack *pack) {
+  if (pack->mapped) munmap((void *)pack->data, pack->size);
+  *pack = (AssetPack) {0};
+}
+
+#ifdef EMBED_ASSETS
+// Pulls the archive into .rodata at build time; the path is resolved by the
+// assembler relative to where the compiler runs, which nob keeps at the root.
+__asm__(
+  "  .section .rodata\n"
+  "  .balign " PACK_ALIGN_STRING "\n"
+  "EmbeddedAssetPack:\n"
+  "  .incbin \"" ASSET_PACK_PATH "\"\n"
+  "EmbeddedAssetPackEnd:\n"
+  "  .previous\n"
+);
+extern const unsigned char EmbeddedAssetPack[];
+extern const unsigned char EmbeddedAssetPackEnd[];
+
+bool OpenEmbeddedAssetPack(AssetPack *pack) {
+  *pack = (AssetPack) {
+    .data = EmbeddedAssetPack,
+    .size = EmbeddedAssetPackEnd - EmbeddedAssetPack,
+  };
+  return LoadPackIndex(pack);
+}
+#endif
+
+static int CompareEntryPath(const void *key, const void *entry) {
+  return strcmp(key, ((const PackEntry *)entry)->path);
+}
+
+const PackEntry *FindPackEntry(const AssetPack *pack, const char *path) {
+  if (pack->entry_count == 0) return NULL;
+  return bsearch(path, pack->entries, pack->entry_count, sizeof(PackEntry), CompareEntryPath);
+}
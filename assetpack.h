@@ -0,0 +1,65 @@
+#ifndef ASSETPACK_H_
+#define ASSETPACK_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// One file holding every image already decoded, written by `./nob pack`:
+//
+//   PackHeader | PackEntry[entry_count], sorted by path | pixel blobs
+//
+// Blobs start on PACK_ALIGN boundaries so they can be handed to the GPU
+// straight out of the mapping.
+#define ASSET_PACK_PATH "assets.pack"
+#define PACK_MAGIC (0x4b504641u)  // "AFPK"
+#define PACK_VERSION (1)
+#define PACK_PATH_SIZE (96)
+#define PACK_ALIGN (64)
+#define PACK_ALIGN_STRING "64"  // for the assembler, keep in sync
+#define PACK_PIXEL_FORMAT (7)    // PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, the only one packed
+#define PACK_PIXEL_SIZE (4)
+
+typedef struct PackHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t entry_count;
+  uint32_t reserved;
+} PackHeader;
+
+typedef struct PackEntry {
+  char path[PACK_PATH_SIZE];  // as passed to LoadImage, NUL terminated
+  uint64_t offset;            // from the start of the file
+  uint64_t size;
+  int32_t width;
+  int32_t height;
+  int32_t format;             // always PACK_PIXEL_FORMAT
+  int32_t mipmaps;            // always 1
+} PackEntry;
+
+typedef struct AssetPack {
+  const unsigned char *data;  // the whole file, mapped read-only
+  size_t size;
+  bool mapped;                // false when data is embedded in the binary
+  const PackEntry *entries;
+  int entry_count;
+} AssetPack;
+
+// Maps the file and checks the index, including that every blob holds
+// exactly the pixels its entry describes. On failure the pack is left
+// empty and lookups simply miss.
+bool OpenAssetPack(AssetPack *pack, const char *path);
+void CloseAssetPack(AssetPack *pack);
+
+#ifdef EMBED_ASSETS
+// The pack linked into the executable by `./nob embed`, no file needed
+bool OpenEmbeddedAssetPack(AssetPack *pack);
+#endif
+
+const PackEntry *FindPackEntry(const AssetPack *pack, const char *path);
+
+static inline const void *GetPackEntryData(const AssetPack *pack, const PackEntry *entry) {
+  return pack->data + entry->offset;
+}
+
+#endif // ASSETPACK_H_
@@ -0,0 +1,536 @@
+// Headless benchmarks for the simulation systems, built and run by `./nob bench`.
+// Pass benchmark names to run a subset: `./nob bench movement`.
+#include "game.h"
+#include "entity.h"
+#include "walkgrid.h"
+#include "pathfind.h"
+#include "jobs.h"
+#include "queue.h"
+#include "timers.h"
+#include "worldgen.h"
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <threads.h>
+#include <time.h>
+
+static double NowSeconds(void) {
+  struct timespec ts;
+  timespec_get(&ts, TIME_UTC);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void BenchMovement(void) {
+  const int movers = 100000;
+  const int iterations = 500;
+
+  EntityWorld world;
+  if (!InitEntityWorld(&world, movers)) {
+    printf("movement: could not allocate %d entities\n", movers);
+    return;
+  }
+
+  for (int i = 0; i < movers; i++) {
+    SpawnEntity(&world, (EntityDesc) {
+      .position = (Vector2) { (i % 1000) * TILE_SIZE, (i / 1000) * TILE_SIZE },
+      .width = 32.f,
+      .height = 32.f,
+      .base_accel = 60,
+      .run_accel_modifier = 1,
+      .texture = CHICKEN,
+      .ai = AI_WANDER,
+    });
+  }
+
+  // Give everyone a heading so the lerp does real work
+  Entity *due = malloc(movers * sizeof(Entity));
+  if (!due) {
+    printf("movement: could not allocate %d entities\n", movers);
+    FreeEntityWorld(&world);
+    return;
+  }
+  int due_count = CollectDueEntityAi(&world, 10.f, due, movers);
+  for (int i = 0; i < due_count; i++) {
+    DecideEntityAi(&world, due[i]);
+  }
+  free(due);
+
+  float dt = 1.f / FPS;
+  UpdateEntityMovement(&world, dt);
+
+  double start = NowSeconds();
+  for (int i = 0; i < iterations; i++) {
+    UpdateEntityMovement(&world, dt);
+  }
+  double elapsed = NowSeconds() - start;
+
+  printf("movement: %d movers, simd width %d, %d threads: %.3f ms/tick, %.2f ns/entity\n",
+      movers, ENTITY_SIMD_WIDTH, GetJobThreadCount(),
+      elapsed * 1e3 / iterations,
+      elapsed * 1e9 / ((double)iterations * movers));
+
+  FreeEntityWorld(&world);
+}
+
+static void BenchPathfinding(void) {
+  const int size = 1000;
+  const int queries = 100;
+
+  WalkGrid grid;
+  Pathfinder finder;
+  PathPoint *route = malloc((size_t)size * size * sizeof(PathPoint));
+  if (!route || !InitWalkGrid(&grid, size, size) || !InitPathfinder(&finder, size, size)) {
+    printf("pathfinding: could not allocate a %dx%d map\n", size, size);
+    return;
+  }
+
+  // Open field scattered with rectangular obstacles (fences, houses, ponds)
+  srand(1234);
+  for (int y = 0; y < size; y++) {
+    for (int x = 0; x < size; x++) {
+      SetCellSolid(&grid, x, y, false);
+    }
+  }
+  for (int i = 0; i < 6000; i++) {
+    int x0 = rand() % size;
+    int y0 = rand() % size;
+    int w = 1 + rand() % 12;
+    int h = 1 + rand() % 12;
+    for (int y = y0; y < y0 + h && y < size; y++) {
+      for (int x = x0; x < x0 + w && x < size; x++) {
+        SetCellSolid(&grid, x, y, true);
+      }
+    }
+  }
+
+  PathPoint starts[100];
+  PathPoint goals[100];
+  for (int i = 0; i < queries; i++) {
+    do {
+      starts[i] = (PathPoint) { rand() % size, rand() % size };
+      goals[i] = (PathPoint) { rand() % size, rand() % size };
+    } while (FindPathJps(&finder, &grid, starts[i], goals[i], route, size * size) == PATH_NOT_FOUND);
+  }
+
+  double astar_length = 0.0;
+  double start = NowSeconds();
+  for (int i = 0; i < queries; i++) {
+    int count = FindPathAStar(&finder, &grid, starts[i], goals[i], route, size * size);
+    astar_length += GetPathLength(route, count);
+  }
+  double astar = NowSeconds() - start;
+
+  double jps_length = 0.0;
+  start = NowSeconds();
+  for (int i = 0; i < queries; i++) {
+    int count = FindPathJps(&finder, &grid, starts[i], goals[i], route, size * size);
+    jps_length += GetPathLength(route, count);
+  }
+  double jps = NowSeconds() - start;
+
+  for (int i = 0; i < queries; i++) {
+    FindPathCached(&finder, &grid, starts[i], goals[i]);
+  }
+  start = NowSeconds();
+  for (int i = 0; i < queries; i++) {
+    FindPathCached(&finder, &grid, starts[i], goals[i]);
+  }
+  double cached = NowSeconds() - start;
+
+  printf("pathfinding: %dx%d map, %d routes, mean length %.1f\n",
+      size, size, queries, astar_length / queries);
+  printf("  A*:     %8.3f ms/route\n", astar * 1e3 / queries);
+  printf("  JPS:    %8.3f ms/route (%.1fx, lengths %s)\n", jps * 1e3 / queries, astar / jps,
+      fabs(astar_length - jps_length) < 1e-2 * queries ? "match" : "DIFFER");
+  printf("  cached: %8.3f ms/route\n", cached * 1e3 / queries);
+
+  FreePathfinder(&finder);
+  FreeWalkGrid(&grid);
+  free(route);
+}
+
+// Stress test for the cross-thread queues: every item has to come out once,
+// and in push order per producer. Worth running under `./nob bench-tsan queues`.
+#define QUEUE_PRODUCERS (4)
+#define QUEUE_ITEMS (1000000)
+
+typedef struct {
+  int producer;
+  int sequence;
+} QueueItem;
+
+typedef struct {
+  SpscQueue *spsc;
+  MpscQueue *mpsc;
+  int producer;
+} QueueProducer;
+
+static int ProduceSpsc(void *arg) {
+  QueueProducer *producer = arg;
+  for (int i = 0; i < QUEUE_ITEMS; i++) {
+    QueueItem item = { producer->producer, i };
+    while (!PushSpscQueue(producer->spsc, &item)) thrd_yield();
+  }
+  return 0;
+}
+
+static int ProduceMpsc(void *arg) {
+  QueueProducer *producer = arg;
+  for (int i = 0; i < QUEUE_ITEMS; i++) {
+    QueueItem item = { producer->producer, i };
+    while (!PushMpscQueue(producer->mpsc, &item)) thrd_yield();
+  }
+  return 0;
+}
+
+static void BenchQueues(void) {
+  SpscQueue spsc;
+  MpscQueue mpsc;
+  if (!InitSpscQueue(&spsc, 1024, sizeof(QueueItem)) ||
+      !InitMpscQueue(&mpsc, 1024, sizeof(QueueItem))) {
+    printf("queues: could not allocate\n");
+    return;
+  }
+
+  int errors = 0;
+  thrd_t threads[QUEUE_PRODUCERS];
+  QueueProducer producers[QUEUE_PRODUCERS];
+
+  double start = NowSeconds();
+  producers[0] = (QueueProducer) { &spsc, NULL, 0 };
+  thrd_create(&threads[0], ProduceSpsc, &producers[0]);
+  for (int expected = 0; expected < QUEUE_ITEMS;) {
+    QueueItem item;
+    if (!PopSpscQueue(&spsc, &item)) {
+      thrd_yield();
+      continue;
+    }
+    if (item.sequence != expected) errors++;
+    expected++;
+  }
+  thrd_join(threads[0], NULL);
+  double spsc_time = NowSeconds() - start;
+
+  int next[QUEUE_PRODUCERS] = {0};
+  start = NowSeconds();
+  for (int i = 0; i < QUEUE_PRODUCERS; i++) {
+    producers[i] = (QueueProducer) { NULL, &mpsc, i };
+    thrd_create(&threads[i], ProduceMpsc, &producers[i]);
+  }
+  for (int received = 0; received < QUEUE_PRODUCERS * QUEUE_ITEMS;) {
+    QueueItem item;
+    if (!PopMpscQueue(&mpsc, &item)) {
+      thrd_yield();
+      continue;
+    }
+    if (item.producer < 0 || item.producer >= QUEUE_PRODUCERS ||
+        item.sequence != next[item.producer]) {
+      errors++;
+    }
+    else {
+      next[item.producer]++;
+    }
+    received++;
+  }
+  for (int i = 0; i < QUEUE_PRODUCERS; i++) {
+    thrd_join(threads[i], NULL);
+  }
+  double mpsc_time = NowSeconds() - start;
+
+  printf("queues: %s\n", errors == 0 ? "ok" : "FAILED");
+  printf("  spsc: %8.2f ns/item, 1 producer\n", spsc_time * 1e9 / QUEUE_ITEMS);
+  printf("  mpsc: %8.2f ns/item, %d producers\n",
+      mpsc_time * 1e9 / ((double)QUEUE_PRODUCERS * QUEUE_ITEMS), QUEUE_PRODUCERS);
+  if (errors) printf("  %d items lost or out of order\n", errors);
+
+  FreeSpscQueue(&spsc);
+  FreeMpscQueue(&mpsc);
+}
+
+// Stress test for RunJobsAfter: chains of batches attached from several
+// threads at once, racing the dependency finishing. Every job checks that
+// the batch before it is complete, and every counter has to drain back to
+// zero. Worth running under `./nob bench-tsan jobs`.
+#define JOB_CHAINS (8)
+#define JOB_CHAIN_BATCHES (16)
+#define JOB_BATCH_SIZE (8)
+#define JOB_ROUNDS (500)
+
+typedef struct JobBatch {
+  const struct JobBatch *after;
+  atomic_int done;
+} JobBatch;
+
+static JobBatch RootBatch;
+static JobBatch ChainBatches[JOB_CHAINS][JOB_CHAIN_BATCHES];
+static JobCounter RootCounter;
+static JobCounter ChainCounters[JOB_CHAINS][JOB_CHAIN_BATCHES];
+static atomic_int JobErrors;
+
+static void RunBatchJob(void *data) {
+  JobBatch *batch = data;
+  if (batch->after && atomic_load(&batch->after->done) != JOB_BATCH_SIZE) {
+    atomic_fetch_add(&JobErrors, 1);
+  }
+  atomic_fetch_add(&batch->done, 1);
+}
+
+static void FillBatch(JobBatch *batch, Job *jobs) {
+  for (int i = 0; i < JOB_BATCH_SIZE; i++) {
+    jobs[i] = (Job) { RunBatchJob, batch };
+  }
+}
+
+// Runs on whichever thread picks it up, so the chains are attached from
+// several threads while the root batch may still be running
+static void SubmitChain(void *data) {
+  int chain = (int)(intptr_t)data;
+  Job jobs[JOB_BATCH_SIZE];
+  for (int k = 0; k < JOB_CHAIN_BATCHES; k++) {
+    FillBatch(&ChainBatches[chain][k], jobs);
+    JobCounter *dependency = k == 0 ? &RootCounter : &ChainCounters[chain][k - 1];
+    RunJobsAfter(dependency, jobs, JOB_BATCH_SIZE, &ChainCounters[chain][k]);
+  }
+}
+
+static bool IsCounterDrained(JobCounter *counter) {
+  return atomic_load(&counter->value) == 0 && atomic_load(&counter->finishing) == 0 &&
+    atomic_load(&counter->continuations) == NULL;
+}
+
+static void BenchJobs(void) {
+  atomic_store(&JobErrors, 0);
+
+  double start = NowSeconds();
+  for (int round = 0; round < JOB_ROUNDS; round++) {
+    RootBatch = (JobBatch) { NULL, 0 };
+    for (int c = 0; c < JOB_CHAINS; c++) {
+      for (int k = 0; k < JOB_CHAIN_BATCHES; k++) {
+        ChainBatches[c][k] = (JobBatch) { k == 0 ? &RootBatch : &ChainBatches[c][k - 1], 0 };
+      }
+    }
+
+    Job jobs[JOB_BATCH_SIZE];
+    FillBatch(&RootBatch, jobs);
+    RunJobs(jobs, JOB_BATCH_SIZE, &RootCounter);
+
+    Job submits[JOB_CHAINS];
+    for (int c = 0; c < JOB_CHAINS; c++) {
+      submits[c] = (Job) { SubmitChain, (void *)(intptr_t)c };
+    }
+    JobCounter submitted = {0};
+    RunJobs(submits, JOB_CHAINS, &submitted);
+    WaitForCounter(&submitted);
+
+    // The last counter of a chain being done means the ones before it are too
+    for (int c = 0; c < JOB_CHAINS; c++) {
+      WaitForCounter(&ChainCounters[c][JOB_CHAIN_BATCHES - 1]);
+    }
+
+    if (!IsCounterDrained(&RootCounter) || atomic_load(&RootBatch.done) != JOB_BATCH_SIZE) {
+      atomic_fetch_add(&JobErrors, 1);
+    }
+    for (int c = 0; c < JOB_CHAINS; c++) {
+      for (int k = 0; k < JOB_CHAIN_BATCHES; k++) {
+        if (!IsCounterDrained(&ChainCounters[c][k]) || atomic_load(&ChainBatches[c][k].done) != JOB_BATCH_SIZE) {
+          atomic_fetch_add(&JobErrors, 1);
+        }
+      }
+    }
+  }
+  double elapsed = NowSeconds() - start;
+
+  int errors = atomic_load(&JobErrors);
+  printf("jobs: %s, %d threads, %d chains of %d batches: %.2f us/batch\n",
+      errors == 0 ? "ok" : "FAILED", GetJobThreadCount(), JOB_CHAINS, JOB_CHAIN_BATCHES,
+      elapsed * 1e6 / ((double)JOB_ROUNDS * (JOB_CHAINS * JOB_CHAIN_BATCHES + 1)));
+  if (errors) printf("  %d jobs ran early or counters left undrained\n", errors);
+}
+
+static void BenchWorldGen(void) {
+  const int size = 4096;
+  const int iterations = 3;
+
+  Tile *tiles = malloc((size_t)size * size * sizeof(Tile));
+  if (!tiles) {
+    printf("worldgen: could not allocate %dx%d tiles\n", size, size);
+    return;
+  }
+
+  WorldGenDesc desc = {
+    .seed = 1337u,
+    .width = size,
+    .height = size,
+    .clearing_width = 30,
+    .clearing_height = 15,
+    .clearing_margin = 8,
+  };
+
+  double best = INFINITY;
+  for (int i = 0; i < iterations; i++) {
+    double start = NowSeconds();
+    if (!GenerateWorld(tiles, desc)) {
+      printf("worldgen: generation failed\n");
+      free(tiles);
+      return;
+    }
+    double elapsed = NowSeconds() - start;
+    if (elapsed < best) best = elapsed;
+  }
+
+  // The same seed has to give the same world on any thread count or SIMD width
+  long long counts[TEXTURE_TYPE_COUNT] = {0};
+  long long trees = 0;
+  unsigned long long checksum = 1469598103934665603ull;
+  for (long long i = 0; i < (long long)size * size; i++) {
+    counts[tiles[i].type]++;
+    trees += tiles[i].object == OBJECT_TREE;
+    checksum = (checksum ^ (tiles[i].type * 31u + tiles[i].object)) * 1099511628211ull;
+  }
+
+  double total = (double)size * size;
+  printf("worldgen: %dx%d tiles, simd width %d, %d threads: %.2f ms, %.2f ns/tile\n",
+      size, size, NOISE_SIMD_WIDTH, GetJobThreadCount(), best * 1e3, best * 1e9 / total);
+  printf("worldgen: grass %.1f%%, dirt %.1f%%, water %.1f%%, hill %.1f%%, trees %.1f%%, checksum %016llx\n",
+      counts[GRASS] * 100 / total, counts[DIRT] * 100 / total, counts[WATER] * 100 / total,
+      counts[HILL] * 100 / total, trees * 100 / total, checksum);
+
+  free(tiles);
+}
+
+// Binary min-heap on expiry, what the timing wheel replaces. Cancelled
+// timers stay in the heap and are skipped when they reach the top.
+typedef struct {
+  uint64_t expires;
+  int timer;
+} HeapTimer;
+
+static void PushHeapTimer(HeapTimer *heap, int *count, HeapTimer timer) {
+  int i = (*count)++;
+  while (i > 0 && heap[(i - 1) / 2].expires > timer.expires) {
+    heap[i] = heap[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  heap[i] = timer;
+}
+
+static HeapTimer PopHeapTimer(HeapTimer *heap, int *count) {
+  HeapTimer top = heap[0];
+  HeapTimer last = heap[--*count];
+  int i = 0;
+  for (;;) {
+    int child = i * 2 + 1;
+    if (child >= *count) break;
+    if (child + 1 < *count && heap[child + 1].expires < heap[child].expires) child++;
+    if (heap[child].expires >= last.expires) break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  heap[i] = last;
+  return top;
+}
+
+static void CountFired(void *ctx, TimerEvent event) {
+  long long *fired = ctx;
+  *fired += event.x;
+}
+
+static void BenchTimers(void) {
+  const int timers = 1000000;
+  const uint64_t horizon = 1u << 20;  // about five hours of ticks
+
+  TimerWheel wheel;
+  HeapTimer *heap = malloc((size_t)timers * sizeof(*heap));
+  TimerId *ids = malloc((size_t)timers * sizeof(*ids));
+  uint64_t *expires = malloc((size_t)timers * sizeof(*expires));
+  bool *cancelled = calloc(timers, sizeof(*cancelled));
+  if (!heap || !ids || !expires || !cancelled || !InitTimerWheel(&wheel, timers, 0)) {
+    printf("timers: could not allocate %d timers\n", timers);
+    free(heap);
+    free(ids);
+    free(expires);
+    free(cancelled);
+    return;
+  }
+
+  unsigned int rng = 12345u;
+  for (int i = 0; i < timers; i++) {
+    rng = rng * 1664525u + 1013904223u;
+    expires[i] = 1 + (rng >> 8) % horizon;
+  }
+
+  // Schedule everything, cancel every fourth, then run the clock out
+  double start = NowSeconds();
+  for (int i = 0; i < timers; i++) {
+    ids[i] = ScheduleTimer(&wheel, expires[i], (TimerEvent) { .x = 1 });
+  }
+  double scheduled = NowSeconds();
+  for (int i = 0; i < timers; i += 4) {
+    CancelTimer(&wheel, ids[i]);
+  }
+  double cancelled_at = NowSeconds();
+  long long wheel_fired = 0;
+  AdvanceTimerWheel(&wheel, horizon, CountFired, &wheel_fired);
+  double wheel_end = NowSeconds();
+  printf("timer wheel: %d timers, schedule %.1f ns, cancel %.1f ns, expire %.1f ns/timer (%lld fired)\n",
+      timers, (scheduled - start) * 1e9 / timers, (cancelled_at - scheduled) * 1e9 / (timers / 4),
+      (wheel_end - cancelled_at) * 1e9 / timers, wheel_fired);
+
+  int count = 0;
+  start = NowSeconds();
+  for (int i = 0; i < timers; i++) {
+    PushHeapTimer(heap, &count, (HeapTimer) { expires[i], i });
+  }
+  scheduled = NowSeconds();
+  for (int i = 0; i < timers; i += 4) {
+    cancelled[i] = true;
+  }
+  cancelled_at = NowSeconds();
+  long long heap_fired = 0;
+  while (count > 0) {
+    HeapTimer timer = PopHeapTimer(heap, &count);
+    if (!cancelled[timer.timer]) heap_fired++;
+  }
+  double heap_end = NowSeconds();
+  printf("binary heap: %d timers, schedule %.1f ns, cancel %.1f ns, expire %.1f ns/timer (%lld fired)\n",
+      timers, (scheduled - start) * 1e9 / timers, (cancelled_at - scheduled) * 1e9 / (timers / 4),
+      (heap_end - cancelled_at) * 1e9 / timers, heap_fired);
+
+  FreeTimerWheel(&wheel);
+  free(heap);
+  free(ids);
+  free(expires);
+  free(cancelled);
+}
+
+typedef struct {
+  const char *name;
+  void (*run)(void);
+} Benchmark;
+
+static const Benchmark Benchmarks[] = {
+  { "jobs", BenchJobs },
+  { "movement", BenchMovement },
+  { "pathfinding", BenchPathfinding },
+  { "queues", BenchQueues },
+  { "timers", BenchTimers },
+  { "worldgen", BenchWorldGen },
+};
+
+int main(int argc, char **argv) {
+  InitJobSystem(0);
+
+  int count = sizeof(Benchmarks) / sizeof(Benchmarks[0]);
+  for (int i = 0; i < count; i++) {
+    int selected = argc <= 1;
+    for (int arg = 1; arg < argc; arg++) {
+      if (strcmp(argv[arg], Benchmarks[i].name) == 0) selected = 1;
+    }
+    if (selected) Benchmarks[i].run();
+  }
+
+  ShutdownJobSystem();
+  return 0;
+}
@@ -0,0 +1,151 @@
+#include "collision.h"
+#include "jobs.h"
+#include <math.h>
+
+// Keeps a blocked box this far away from the wall so float rounding can't
+// leave its edge inside the solid cell. A power of two so it is still
+// representable at the coordinates of a 4096 tile wide map.
+#define SKIN (1.f / 64.f)
+
+// Sweeps are much heavier than a movement step, so smaller batches pay off
+#define COLLISION_GRAIN (1024)
+
+static inline int CellOf(float v) {
+  return floorf(v / TILE_SIZE);
+}
+
+// Last cell covered by a box whose far edge (exclusive) is at v
+static inline int LastCellOf(float v) {
+  return ceilf(v / TILE_SIZE) - 1;
+}
+
+static bool IsColumnBlocked(const WalkGrid *grid, int column, int row0, int row1) {
+  for (int row = row0; row <= row1; row++) {
+    if (IsCellSolid(grid, column, row)) return true;
+  }
+  return false;
+}
+
+static bool IsRowBlocked(const WalkGrid *grid, int row, int column0, int column1) {
+  for (int column = column0; column <= column1; column++) {
+    if (IsCellSolid(grid, column, row)) return true;
+  }
+  return false;
+}
+
+static bool SweepX(const WalkGrid *grid, Rectangle *box, float dx) {
+  if (dx == 0.f) return false;
+
+  int row0 = CellOf(box->y);
+  int row1 = LastCellOf(box->y + box->height);
+
+  if (dx > 0.f) {
+    float edge = box->x + box->width;
+    int first = LastCellOf(edge) + 1;
+    int last = LastCellOf(edge + dx);
+    for (int column = first; column <= last; column++) {
+      if (IsColumnBlocked(grid, column, row0, row1)) {
+        box->x = column * TILE_SIZE - box->width - SKIN;
+        return true;
+      }
+    }
+  }
+  else {
+    int first = CellOf(box->x) - 1;
+    int last = CellOf(box->x + dx);
+    for (int column = first; column >= last; column--) {
+      if (IsColumnBlocked(grid, column, row0, row1)) {
+        box->x = (column + 1) * TILE_SIZE + SKIN;
+        return true;
+      }
+    }
+  }
+
+  box->x += dx;
+  return false;
+}
+
+static bool SweepY(const WalkGrid *grid, Rectangle *box, float dy) {
+  if (dy == 0.f) return false;
+
+  int column0 = CellOf(box->x);
+  int column1 = LastCellOf(box->x + box->width);
+
+  if (dy > 0.f) {
+    float edge = box->y + box->height;
+    int first = LastCellOf(edge) + 1;
+    int last = LastCellOf(edge + dy);
+    for (int row = first; row <= last; row++) {
+      if (IsRowBlocked(grid, row, column0, column1)) {
+        box->y = row * TILE_SIZE - box->height - SKIN;
+        return true;
+      }
+    }
+  }
+  else {
+    int first = CellOf(box->y) - 1;
+    int last = CellOf(box->y + dy);
+    for (int row = first; row >= last; row--) {
+      if (IsRowBlocked(grid, row, column0, column1)) {
+        box->y = (row + 1) * TILE_SIZE + SKIN;
+        return true;
+      }
+    }
+  }
+
+  box->y += dy;
+  return false;
+}
+
+int SweepBox(const WalkGrid *grid, Rectangle *box, Vector2 delta) {
+  int flags = COLLIDED_NONE;
+  if (SweepX(grid, box, delta.x)) flags |= COLLIDED_X;
+  if (SweepY(grid, box, delta.y)) flags |= COLLIDED_Y;
+  return flags;
+}
+
+typedef struct {
+  EntityWorld *world;
+  const WalkGrid *grid;
+} CollisionJob;
+
+static void ResolveCollisionRange(void *ctx, int begin, int end) {
+  CollisionJob *job = ctx;
+  const WalkGrid *grid = job->grid;
+  TransformComponents *tr = &job->world->transform;
+  VelocityComponents *vel = &job->world->velocity;
+
+  for (int i = begin; i < end; i++) {
+    float dx = tr->pos_x[i] - tr->prev_x[i];
+    float dy = tr->pos_y[i] - tr->prev_y[i];
+    if (dx == 0.f && dy == 0.f) continue;
+
+    // Collide with the lower half of the sprite so entities can overlap
+    // walls and each other visually the way top-down sprites do.
+    float offset_x = tr->width[i] / 4.f;
+    float offset_y = tr->height[i] / 2.f;
+    Rectangle feet = {
+      tr->prev_x[i] + offset_x,
+      tr->prev_y[i] + offset_y,
+      tr->width[i] / 2.f,
+      tr->height[i] / 2.f,
+    };
+
+    int flags = SweepBox(grid, &feet, (Vector2) { dx, dy });
+    if (flags == COLLIDED_NONE) continue;
+
+    tr->pos_x[i] = feet.x - offset_x;
+    tr->pos_y[i] = feet.y - offset_y;
+    if (flags & COLLIDED_X) vel->vel_x[i] = 0.f;
+    if (flags & COLLIDED_Y) vel->vel_y[i] = 0.f;
+
+    tr->cell_x[i] = floorf((tr->pos_x[i] + (tr->width[i] / 2.f)) / TILE_SIZE);
+    tr->cell_y[i] = floorf((tr->pos_y[i] + (tr->height[i] / 2.f)) / TILE_SIZE);
+  }
+}
+
+void ResolveEntityCollisions(EntityWorld *world, const WalkGrid *grid) {
+  // Each entity only reads the grid and writes its own components
+  CollisionJob job = { world, grid };
+  ParallelFor(0, world->count, COLLISION_GRAIN, ResolveCollisionRange, &job);
+}
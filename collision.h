@@ -0,0 +1,24 @@
+#ifndef COLLISION_H_
+#define COLLISION_H_
+
+#include "external/raylib-5.5/src/raylib.h"
+#include "entity.h"
+#include "walkgrid.h"
+
+typedef enum {
+  COLLIDED_NONE = 0,
+  COLLIDED_X = 1 << 0,
+  COLLIDED_Y = 1 << 1,
+} CollisionFlags;
+
+// Moves box by delta against the solid cells of grid, one axis at a time.
+// Only the cells the moving edge sweeps over are tested, so the cost grows
+// with the distance travelled and not with the size of the map.
+// Returns CollisionFlags for the axes that were blocked.
+int SweepBox(const WalkGrid *grid, Rectangle *box, Vector2 delta);
+
+// Re-runs this tick's movement of every entity (prev_x/prev_y -> pos_x/pos_y)
+// through SweepBox using the entity's feet as its collider.
+void ResolveEntityCollisions(EntityWorld *world, const WalkGrid *grid);
+
+#endif // COLLISION_H_
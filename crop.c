@@ -0,0 +1,51 @@
+#include "crop.h"
+
+const CropDef CropDefs[CROP_TYPE_COUNT] = {
+  [CROP_NONE] = { .ticks_per_stage = 1, .watered_rate = 1 },  // lookups on empty tiles stay harmless
+  [CROP_WHEAT] = { .ticks_per_stage = 20 * FPS, .watered_rate = 2 },
+  [CROP_TOMATO] = { .ticks_per_stage = 30 * FPS, .watered_rate = 2 },
+};
+
+bool PlantCrop(Tile *tile, CropType crop, unsigned long long tick) {
+  if (tile->type != DIRT || tile->object != OBJECT_NONE || tile->crop != CROP_NONE) return false;
+
+  tile->crop = crop;
+  tile->crop_planted = (unsigned int)tick;
+  tile->crop_watered = false;
+  return true;
+}
+
+bool WaterCrop(Tile *tile, unsigned long long tick) {
+  if (tile->crop == CROP_NONE || tile->crop_watered) return false;
+
+  // Move the planting tick so the faster rate lands on the current age
+  unsigned int age = GetCropAge(*tile, tick);
+  tile->crop_planted = (unsigned int)tick - age / CropDefs[tile->crop].watered_rate;
+  tile->crop_watered = true;
+  return true;
+}
+
+bool DryCrop(Tile *tile, unsigned long long tick) {
+  if (tile->crop == CROP_NONE || !tile->crop_watered) return false;
+
+  unsigned int age = GetCropAge(*tile, tick);
+  tile->crop_planted = (unsigned int)tick - age;
+  tile->crop_watered = false;
+  return true;
+}
+
+CropType HarvestCrop(Tile *tile, unsigned long long tick) {
+  if (!IsCropRipe(*tile, tick)) return CROP_NONE;
+
+  CropType crop = tile->crop;
+  tile->crop = CROP_NONE;
+  tile->crop_planted = 0;
+  tile->crop_watered = false;
+  return crop;
+}
+
+bool TillTile(Tile *tile) {
+  if (tile->type != GRASS || tile->object != OBJECT_NONE) return false;
+  tile->type = DIRT;
+  return true;
+}
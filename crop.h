@@ -0,0 +1,59 @@
+#ifndef CROP_H_
+#define CROP_H_
+
+#include "game.h"
+#include <limits.h>
+#include <stdbool.h>
+
+#define CROP_STAGE_COUNT (4)
+
+// A crop is only the tick it was planted and whether it has been watered.
+// Nothing steps crops forward: their stage is worked out from the current
+// tick whenever a tile is drawn, queried or harvested, so a field costs the
+// same whether it has ten crops or a million.
+typedef struct CropDef {
+  unsigned int ticks_per_stage;
+  unsigned int watered_rate;  // growth speedup once watered
+} CropDef;
+
+extern const CropDef CropDefs[CROP_TYPE_COUNT];
+
+// crop_planted is kept as the tick growth would have started on if the crop
+// had always grown at its current rate, so age is one subtraction. Ticks are
+// compared modulo 2^32, which is two years of play at 60 ticks a second.
+static inline unsigned int GetCropAge(Tile tile, unsigned long long tick) {
+  unsigned int elapsed = (unsigned int)tick - tile.crop_planted;
+  return tile.crop_watered ? elapsed * CropDefs[tile.crop].watered_rate : elapsed;
+}
+
+// 0 .. CROP_STAGE_COUNT - 1, the last stage is ripe
+static inline int GetCropStage(Tile tile, unsigned long long tick) {
+  unsigned int stage = GetCropAge(tile, tick) / CropDefs[tile.crop].ticks_per_stage;
+  return stage < CROP_STAGE_COUNT - 1 ? (int)stage : CROP_STAGE_COUNT - 1;
+}
+
+// Tick the crop shows its next stage on, ULLONG_MAX once it is ripe
+static inline unsigned long long GetCropNextStageTick(Tile tile, unsigned long long tick) {
+  int stage = GetCropStage(tile, tick);
+  if (stage == CROP_STAGE_COUNT - 1) return ULLONG_MAX;
+  unsigned int rate = tile.crop_watered ? CropDefs[tile.crop].watered_rate : 1;
+  unsigned int remaining = (stage + 1) * CropDefs[tile.crop].ticks_per_stage - GetCropAge(tile, tick);
+  return tick + (remaining + rate - 1) / rate;
+}
+
+static inline bool IsCropRipe(Tile tile, unsigned long long tick) {
+  return tile.crop != CROP_NONE && GetCropStage(tile, tick) == CROP_STAGE_COUNT - 1;
+}
+
+// Only on bare tilled soil
+bool PlantCrop(Tile *tile, CropType crop, unsigned long long tick);
+// Speeds up the rest of the growth, keeping what has grown so far
+bool WaterCrop(Tile *tile, unsigned long long tick);
+// Back to the normal rate once the water has worn off
+bool DryCrop(Tile *tile, unsigned long long tick);
+// Clears a ripe crop off the tile and returns it, CROP_NONE if there was none
+CropType HarvestCrop(Tile *tile, unsigned long long tick);
+// Turns grass into tilled soil
+bool TillTile(Tile *tile);
+
+#endif // CROP_H_
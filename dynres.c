@@ -0,0 +1,40 @@
+#include "dynres.h"
+
+#define LATE_FRAME (1.1f)  // of the budget, vsync jitter stays under it
+#define HIGH_WATER (0.9f)
+#define LOW_WATER (0.6f)
+#define SMOOTHING (0.2f)   // weight of the newest frame
+
+bool UpdateDynamicResolution(DynamicResolution *resolution, float frame_time, float busy_time) {
+  float budget = resolution->budget;
+  if (resolution->frame_time == 0.f) {
+    resolution->frame_time = frame_time;
+    resolution->busy_time = busy_time;
+  }
+  resolution->frame_time += (frame_time - resolution->frame_time) * SMOOTHING;
+  resolution->busy_time += (busy_time - resolution->busy_time) * SMOOTHING;
+
+  bool late = resolution->frame_time > budget * LATE_FRAME;
+  bool busy = resolution->busy_time > budget * HIGH_WATER;
+  bool idle = resolution->busy_time < budget * LOW_WATER;
+  resolution->over = late || busy ? resolution->over + 1 : 0;
+  resolution->under = !late && idle ? resolution->under + 1 : 0;
+  if (resolution->hold > 0) resolution->hold--;
+
+  float scale = resolution->scale;
+  if (resolution->over >= DYNRES_DROP_FRAMES) {
+    scale -= resolution->step;
+    resolution->hold = DYNRES_HOLD_FRAMES;
+  }
+  else if (resolution->under >= DYNRES_RAISE_FRAMES && resolution->hold == 0) {
+    scale += resolution->step;
+  }
+  if (scale < resolution->min_scale) scale = resolution->min_scale;
+  if (scale > resolution->max_scale) scale = resolution->max_scale;
+  if (scale == resolution->scale) return false;
+
+  resolution->scale = scale;
+  resolution->over = 0;
+  resolution->under = 0;
+  return true;
+}
@@ -0,0 +1,34 @@
+#ifndef DYNRES_H_
+#define DYNRES_H_
+
+#include <stdbool.h>
+
+#define DYNRES_DROP_FRAMES (5)    // frames over budget in a row before stepping down
+#define DYNRES_RAISE_FRAMES (90)  // frames well under budget in a row before stepping up
+#define DYNRES_HOLD_FRAMES (180)  // no stepping up for this long after a step down
+
+// Picks the world's render resolution, as a fraction of the screen's, from
+// how long frames take, smoothed over the last few. It is over budget when
+// frames run late or their own work comes close to the budget, and well
+// under when the work is far below it. Stepping down takes a few bad frames,
+// stepping back up a long run of good ones, so the scale doesn't hunt back
+// and forth around the limit.
+typedef struct DynamicResolution {
+  float min_scale;
+  float max_scale;
+  float step;
+  float budget;  // seconds per frame
+  float scale;
+
+  float frame_time;  // smoothed
+  float busy_time;
+  int over;
+  int under;
+  int hold;
+} DynamicResolution;
+
+// frame_time is the whole frame, waits included; busy_time is the part spent
+// working. Returns true when the scale changed.
+bool UpdateDynamicResolution(DynamicResolution *resolution, float frame_time, float busy_time);
+
+#endif // DYNRES_H_
@@ -0,0 +1,409 @@
+#include "entity.h"
+#include "jobs.h"
+#include "external/raylib-5.5/src/raymath.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define COMPONENT_ALIGN (32)
+
+// Entities per job when movement is spread across threads. A multiple of
+// every SIMD width so each range starts on an aligned batch.
+#define MOVEMENT_GRAIN (4096)
+#define ANIMATION_GRAIN (4096)
+
+// Below this fraction of its top speed an entity counts as standing still
+#define WALK_SPEED_FRACTION (0.25f)
+
+#define COMPONENT_FIELDS(X)          \
+  X(transform.pos_x)                 \
+  X(transform.pos_y)                 \
+  X(transform.prev_x)                \
+  X(transform.prev_y)                \
+  X(transform.width)                 \
+  X(transform.height)                \
+  X(transform.cell_x)                \
+  X(transform.cell_y)                \
+  X(velocity.vel_x)                  \
+  X(velocity.vel_y)                  \
+  X(velocity.dir_x)                  \
+  X(velocity.dir_y)                  \
+  X(velocity.base_accel)             \
+  X(velocity.run_accel_modifier)     \
+  X(velocity.current_accel)          \
+  X(sprite.texture)                  \
+  X(sprite.clip)                     \
+  X(sprite.clip_frame)               \
+  X(sprite.inv_max_speed)            \
+  X(sprite.facing)                   \
+  X(sprite.frame_rect)               \
+  X(ai.kind)                         \
+  X(ai.timer)                        \
+  X(ai.rng)
+
+static void *AllocComponent(size_t elem_size, int capacity) {
+  size_t size = elem_size * capacity;
+  size = (size + COMPONENT_ALIGN - 1) & ~(size_t)(COMPONENT_ALIGN - 1);
+  void *data = aligned_alloc(COMPONENT_ALIGN, size);
+  if (data) memset(data, 0, size);
+  return data;
+}
+
+bool InitEntityWorld(EntityWorld *world, int capacity) {
+  *world = (EntityWorld) { .capacity = capacity };
+
+  world->handle_of = calloc(capacity, sizeof(*world->handle_of));
+  world->index_of = calloc(capacity, sizeof(*world->index_of));
+  world->free_handles = calloc(capacity, sizeof(*world->free_handles));
+  if (!world->handle_of || !world->index_of || !world->free_handles) {
+    FreeEntityWorld(world);
+    return false;
+  }
+
+#define X(field)                                                   \
+  world->field = AllocComponent(sizeof(*world->field), capacity);  \
+  if (!world->field) {                                             \
+    FreeEntityWorld(world);                                        \
+    return false;                                                  \
+  }
+  COMPONENT_FIELDS(X)
+#undef X
+
+  for (int i = 0; i < capacity; i++) {
+    world->index_of[i] = -1;
+  }
+  return true;
+}
+
+void FreeEntityWorld(EntityWorld *world) {
+  free(world->handle_of);
+  free(world->index_of);
+  free(world->free_handles);
+#define X(field) free(world->field);
+  COMPONENT_FIELDS(X)
+#undef X
+  *world = (EntityWorld) {0};
+}
+
+Entity SpawnEntity(EntityWorld *world, EntityDesc desc) {
+  if (world->count >= world->capacity) {
+    return ENTITY_NONE;
+  }
+
+  Entity entity = world->free_count > 0
+    ? world->free_handles[--world->free_count]
+    : world->next_handle++;
+
+  int i = world->count++;
+  world->handle_of[i] = entity;
+  world->index_of[entity] = i;
+
+  world->transform.pos_x[i] = desc.position.x;
+  world->transform.pos_y[i] = desc.position.y;
+  world->transform.prev_x[i] = desc.position.x;
+  world->transform.prev_y[i] = desc.position.y;
+  world->transform.width[i] = desc.width;
+  world->transform.height[i] = desc.height;
+  world->transform.cell_x[i] = floorf((desc.position.x + desc.width / 2.f) / TILE_SIZE);
+  world->transform.cell_y[i] = floorf((desc.position.y + desc.height / 2.f) / TILE_SIZE);
+
+  world->velocity.vel_x[i] = 0.f;
+  world->velocity.vel_y[i] = 0.f;
+  world->velocity.dir_x[i] = 0.f;
+  world->velocity.dir_y[i] = 0.f;
+  world->velocity.base_accel[i] = desc.base_accel;
+  world->velocity.run_accel_modifier[i] = desc.run_accel_modifier;
+  world->velocity.current_accel[i] = desc.base_accel;
+
+  world->sprite.texture[i] = desc.texture;
+  world->sprite.clip[i] = IdleClips[desc.texture];
+  world->sprite.clip_frame[i] = 0.f;
+  float max_speed = desc.base_accel * desc.run_accel_modifier;
+  world->sprite.inv_max_speed[i] = max_speed > 0.f ? 1.f / max_speed : 0.f;
+  world->sprite.facing[i] = FACING_DOWN;
+  world->sprite.frame_rect[i] = AnimClips[world->sprite.clip[i]].frames[0];
+
+  world->ai.kind[i] = desc.ai;
+  world->ai.timer[i] = 0.f;
+  world->ai.rng[i] = 2654435761u * (unsigned int)(entity + 1);
+
+  return entity;
+}
+
+void DespawnEntity(EntityWorld *world, Entity entity) {
+  int i = GetEntityIndex(world, entity);
+  if (i < 0) return;
+
+  // Keep the arrays dense: move the last entity into the hole
+  int last = --world->count;
+  if (i != last) {
+#define X(field) world->field[i] = world->field[last];
+    COMPONENT_FIELDS(X)
+#undef X
+    world->handle_of[i] = world->handle_of[last];
+    world->index_of[world->handle_of[i]] = i;
+  }
+
+  world->index_of[entity] = -1;
+  world->free_handles[world->free_count++] = entity;
+}
+
+int GetEntityIndex(const EntityWorld *world, Entity entity) {
+  if (entity < 0 || entity >= world->capacity) {
+    return -1;
+  }
+  return world->index_of[entity];
+}
+
+static unsigned int NextRandom(unsigned int *state) {
+  // xorshift32, per entity so the AI pass doesn't share global state
+  unsigned int x = *state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  return *state = x;
+}
+
+static void DecideWander(EntityWorld *world, int i) {
+  AiComponents *ai = &world->ai;
+  VelocityComponents *vel = &world->velocity;
+
+  unsigned int r = NextRandom(&ai->rng[i]);
+  // one in three decisions is to stand still
+  if (r % 3 == 0) {
+    vel->dir_x[i] = 0.f;
+    vel->dir_y[i] = 0.f;
+  }
+  else {
+    vel->dir_x[i] = (int)((r >> 8) % 3) - 1;
+    vel->dir_y[i] = (int)((r >> 16) % 3) - 1;
+  }
+  vel->current_accel[i] = vel->base_accel[i];
+  ai->timer[i] = 1.f + (r >> 24) / 128.f;
+}
+
+int CollectDueEntityAi(EntityWorld *world, float dt, Entity *due, int capacity) {
+  AiComponents *ai = &world->ai;
+  int count = 0;
+
+  for (int i = 0; i < world->count; i++) {
+    if (ai->kind[i] != AI_WANDER) continue;
+
+    ai->timer[i] -= dt;
+    if (ai->timer[i] > 0.f || count == capacity) continue;
+    // Parked until DecideEntityAi gets to it, so it isn't handed out twice
+    ai->timer[i] = INFINITY;
+    due[count++] = world->handle_of[i];
+  }
+  return count;
+}
+
+void DecideEntityAi(EntityWorld *world, Entity entity) {
+  int i = GetEntityIndex(world, entity);
+  if (i < 0) return;
+
+  if (world->ai.kind[i] == AI_WANDER) {
+    DecideWander(world, i);
+  }
+  else {
+    // Switched away while waiting; due again as soon as it wanders
+    world->ai.timer[i] = 0.f;
+  }
+}
+
+static void MoveEntitiesScalar(EntityWorld *world, int begin, int end, float dt) {
+  TransformComponents *tr = &world->transform;
+  VelocityComponents *vel = &world->velocity;
+  float t = dt * 14.0f;
+
+  for (int i = begin; i < end; i++) {
+    vel->vel_x[i] = Lerp(vel->vel_x[i], vel->dir_x[i] * vel->current_accel[i], t);
+    vel->vel_y[i] = Lerp(vel->vel_y[i], vel->dir_y[i] * vel->current_accel[i], t);
+
+    tr->prev_x[i] = tr->pos_x[i];
+    tr->prev_y[i] = tr->pos_y[i];
+    tr->pos_x[i] += vel->vel_x[i] * dt;
+    tr->pos_y[i] += vel->vel_y[i] * dt;
+
+    tr->cell_x[i] = floorf((tr->pos_x[i] + (tr->width[i] / 2.f)) / TILE_SIZE);
+    tr->cell_y[i] = floorf((tr->pos_y[i] + (tr->height[i] / 2.f)) / TILE_SIZE);
+  }
+}
+
+#if defined(__AVX__)
+static int MoveEntitiesSimd(EntityWorld *world, int begin, int end, float dt) {
+  TransformComponents *tr = &world->transform;
+  VelocityComponents *vel = &world->velocity;
+  __m256 t = _mm256_set1_ps(dt * 14.0f);
+  __m256 step = _mm256_set1_ps(dt);
+  __m256 half = _mm256_set1_ps(0.5f);
+  __m256 tile = _mm256_set1_ps(TILE_SIZE);
+
+  int i = begin;
+  for (; i + 8 <= end; i += 8) {
+    __m256 accel = _mm256_load_ps(&vel->current_accel[i]);
+
+    __m256 vx = _mm256_load_ps(&vel->vel_x[i]);
+    __m256 vy = _mm256_load_ps(&vel->vel_y[i]);
+    __m256 target_x = _mm256_mul_ps(_mm256_load_ps(&vel->dir_x[i]), accel);
+    __m256 target_y = _mm256_mul_ps(_mm256_load_ps(&vel->dir_y[i]), accel);
+    vx = _mm256_add_ps(vx, _mm256_mul_ps(t, _mm256_sub_ps(target_x, vx)));
+    vy = _mm256_add_ps(vy, _mm256_mul_ps(t, _mm256_sub_ps(target_y, vy)));
+    _mm256_store_ps(&vel->vel_x[i], vx);
+    _mm256_store_ps(&vel->vel_y[i], vy);
+
+    __m256 px = _mm256_load_ps(&tr->pos_x[i]);
+    __m256 py = _mm256_load_ps(&tr->pos_y[i]);
+    _mm256_store_ps(&tr->prev_x[i], px);
+    _mm256_store_ps(&tr->prev_y[i], py);
+    px = _mm256_add_ps(px, _mm256_mul_ps(vx, step));
+    py = _mm256_add_ps(py, _mm256_mul_ps(vy, step));
+    _mm256_store_ps(&tr->pos_x[i], px);
+    _mm256_store_ps(&tr->pos_y[i], py);
+
+    __m256 cx = _mm256_div_ps(_mm256_add_ps(px, _mm256_mul_ps(_mm256_load_ps(&tr->width[i]), half)), tile);
+    __m256 cy = _mm256_div_ps(_mm256_add_ps(py, _mm256_mul_ps(_mm256_load_ps(&tr->height[i]), half)), tile);
+    _mm256_store_si256((__m256i *)&tr->cell_x[i], _mm256_cvttps_epi32(_mm256_floor_ps(cx)));
+    _mm256_store_si256((__m256i *)&tr->cell_y[i], _mm256_cvttps_epi32(_mm256_floor_ps(cy)));
+  }
+  return i;
+}
+#elif defined(__SSE2__)
+// SSE2 has no floor instruction: truncate, then step down where truncation rounded up
+static inline __m128i FloorToInt(__m128 x) {
+  __m128i i = _mm_cvttps_epi32(x);
+  __m128 rounded_up = _mm_cmpgt_ps(_mm_cvtepi32_ps(i), x);
+  return _mm_add_epi32(i, _mm_castps_si128(rounded_up));
+}
+
+static int MoveEntitiesSimd(EntityWorld *world, int begin, int end, float dt) {
+  TransformComponents *tr = &world->transform;
+  VelocityComponents *vel = &world->velocity;
+  __m128 t = _mm_set1_ps(dt * 14.0f);
+  __m128 step = _mm_set1_ps(dt);
+  __m128 half = _mm_set1_ps(0.5f);
+  __m128 tile = _mm_set1_ps(TILE_SIZE);
+
+  int i = begin;
+  for (; i + 4 <= end; i += 4) {
+    __m128 accel = _mm_load_ps(&vel->current_accel[i]);
+
+    __m128 vx = _mm_load_ps(&vel->vel_x[i]);
+    __m128 vy = _mm_load_ps(&vel->vel_y[i]);
+    __m128 target_x = _mm_mul_ps(_mm_load_ps(&vel->dir_x[i]), accel);
+    __m128 target_y = _mm_mul_ps(_mm_load_ps(&vel->dir_y[i]), accel);
+    vx = _mm_add_ps(vx, _mm_mul_ps(t, _mm_sub_ps(target_x, vx)));
+    vy = _mm_add_ps(vy, _mm_mul_ps(t, _mm_sub_ps(target_y, vy)));
+    _mm_store_ps(&vel->vel_x[i], vx);
+    _mm_store_ps(&vel->vel_y[i], vy);
+
+    __m128 px = _mm_load_ps(&tr->pos_x[i]);
+    __m128 py = _mm_load_ps(&tr->pos_y[i]);
+    _mm_store_ps(&tr->prev_x[i], px);
+    _mm_store_ps(&tr->prev_y[i], py);
+    px = _mm_add_ps(px, _mm_mul_ps(vx, step));
+    py = _mm_add_ps(py, _mm_mul_ps(vy, step));
+    _mm_store_ps(&tr->pos_x[i], px);
+    _mm_store_ps(&tr->pos_y[i], py);
+
+    __m128 cx = _mm_div_ps(_mm_add_ps(px, _mm_mul_ps(_mm_load_ps(&tr->width[i]), half)), tile);
+    __m128 cy = _mm_div_ps(_mm_add_ps(py, _mm_mul_ps(_mm_load_ps(&tr->height[i]), half)), tile);
+    _mm_store_si128((__m128i *)&tr->cell_x[i], FloorToInt(cx));
+    _mm_store_si128((__m128i *)&tr->cell_y[i], FloorToInt(cy));
+  }
+  return i;
+}
+#else
+static int MoveEntitiesSimd(EntityWorld *world, int begin, int end, float dt) {
+  (void)world;
+  (void)end;
+  (void)dt;
+  return begin;
+}
+#endif
+
+typedef struct {
+  EntityWorld *world;
+  float dt;
+} EntityJob;
+
+static void MoveEntityRange(void *ctx, int begin, int end) {
+  EntityJob *job = ctx;
+  // Full vector batches first, the remainder goes through the scalar path
+  int done = MoveEntitiesSimd(job->world, begin, end, job->dt);
+  MoveEntitiesScalar(job->world, done, end, job->dt);
+}
+
+void UpdateEntityMovement(EntityWorld *world, float dt) {
+  EntityJob job = { world, dt };
+  ParallelFor(0, world->count, MOVEMENT_GRAIN, MoveEntityRange, &job);
+}
+
+static void AnimateEntityRange(void *ctx, int begin, int end) {
+  EntityJob *job = ctx;
+  const VelocityComponents *vel = &job->world->velocity;
+  SpriteComponents *sprite = &job->world->sprite;
+
+  for (int i = begin; i < end; i++) {
+    float vx = fabsf(vel->vel_x[i]);
+    float vy = fabsf(vel->vel_y[i]);
+    float inv_max_speed = sprite->inv_max_speed[i];
+    bool moving = fmaxf(vx, vy) * inv_max_speed > WALK_SPEED_FRACTION;
+    if (moving) {
+      sprite->facing[i] = vx >= vy
+        ? (vel->vel_x[i] < 0.f ? FACING_LEFT : FACING_RIGHT)
+        : (vel->vel_y[i] < 0.f ? FACING_UP : FACING_DOWN);
+    }
+    AnimClipId locomotion = moving ? WalkClips[sprite->texture[i]] : IdleClips[sprite->texture[i]];
+
+    // Looping clips follow the entity's speed, one-shots finish first
+    AnimClipId clip = sprite->clip[i];
+    float frame = sprite->clip_frame[i];
+    const AnimClip *current = &AnimClips[clip];
+    if (current->loop && clip != locomotion) {
+      clip = locomotion;
+      current = &AnimClips[clip];
+      frame = 0.f;
+    }
+
+    float rate = current->speed_scaled ? (vx + vy) * inv_max_speed : 1.f;
+    frame += job->dt * current->frames_per_second * rate;
+    if (frame >= current->frame_count) {
+      if (current->loop) {
+        frame = fmodf(frame, current->frame_count);
+      }
+      else {
+        clip = locomotion;
+        current = &AnimClips[clip];
+        frame = 0.f;
+      }
+    }
+    sprite->clip[i] = clip;
+    sprite->clip_frame[i] = frame;
+
+    // Up and down keep whichever way the sprite was last mirrored
+    Rectangle rect = current->frames[(int)frame];
+    Facing facing = sprite->facing[i];
+    bool mirrored = facing == FACING_LEFT || (facing != FACING_RIGHT && sprite->frame_rect[i].width < 0.f);
+    if (current->flip_left && mirrored) rect.width = -rect.width;
+    sprite->frame_rect[i] = rect;
+  }
+}
+
+void UpdateEntityAnimation(EntityWorld *world, float dt) {
+  EntityJob job = { world, dt };
+  ParallelFor(0, world->count, ANIMATION_GRAIN, AnimateEntityRange, &job);
+}
+
+void PlayEntityClip(EntityWorld *world, Entity entity, AnimClipId clip) {
+  int i = GetEntityIndex(world, entity);
+  if (i < 0) return;
+  world->sprite.clip[i] = clip;
+  world->sprite.clip_frame[i] = 0.f;
+}
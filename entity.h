@@ -0,0 +1,114 @@
+#ifndef ENTITY_H_
+#define ENTITY_H_
+
+#include "external/raylib-5.5/src/raylib.h"
+#include "game.h"
+#include "anim.h"
+#include <stdbool.h>
+
+#define ENTITY_NONE (-1)
+
+// Number of entities the movement system advances per instruction
+#if defined(__AVX__)
+#define ENTITY_SIMD_WIDTH (8)
+#elif defined(__SSE2__)
+#define ENTITY_SIMD_WIDTH (4)
+#else
+#define ENTITY_SIMD_WIDTH (1)
+#endif
+
+// Stable handle. Dense indices move when entities are despawned, handles don't.
+typedef int Entity;
+
+typedef enum {
+  AI_NONE,   // direction is written from outside (player input)
+  AI_WANDER,
+  AI_FOLLOW,  // steered along a shared flow field
+  AI_KIND_COUNT
+} AiKind;
+
+// Every component is a set of parallel arrays indexed by the dense entity
+// index, so a system only touches the fields it reads and writes. Arrays are
+// 32-byte aligned so the movement system can use aligned vector loads.
+typedef struct {
+  float *pos_x;
+  float *pos_y;
+  float *prev_x;  // position before the last movement step
+  float *prev_y;
+  float *width;
+  float *height;
+  int *cell_x;
+  int *cell_y;
+} TransformComponents;
+
+typedef struct {
+  float *vel_x;
+  float *vel_y;
+  float *dir_x;
+  float *dir_y;
+  float *base_accel;
+  float *run_accel_modifier;
+  float *current_accel;
+} VelocityComponents;
+
+typedef struct {
+  TextureType *texture;   // the entity's own sheet, picks its idle and walk clips
+  AnimClipId *clip;
+  float *clip_frame;      // how far into the clip, in frames
+  float *inv_max_speed;   // walk clips play at full rate at 1 / this
+  Facing *facing;
+  Rectangle *frame_rect;  // negative width when mirrored
+} SpriteComponents;
+
+typedef struct {
+  AiKind *kind;
+  float *timer;
+  unsigned int *rng;
+} AiComponents;
+
+typedef struct EntityWorld {
+  int count;
+  int capacity;
+
+  Entity *handle_of;  // dense index -> handle
+  int *index_of;      // handle -> dense index, -1 when free
+  Entity *free_handles;
+  int free_count;
+  int next_handle;
+
+  TransformComponents transform;
+  VelocityComponents velocity;
+  SpriteComponents sprite;
+  AiComponents ai;
+} EntityWorld;
+
+typedef struct {
+  Vector2 position;
+  float width;
+  float height;
+  float base_accel;
+  float run_accel_modifier;
+  TextureType texture;
+  AiKind ai;
+} EntityDesc;
+
+bool InitEntityWorld(EntityWorld *world, int capacity);
+void FreeEntityWorld(EntityWorld *world);
+
+Entity SpawnEntity(EntityWorld *world, EntityDesc desc);
+void DespawnEntity(EntityWorld *world, Entity entity);
+int GetEntityIndex(const EntityWorld *world, Entity entity);
+
+// Wander AI in two steps, so the decisions can be spread over ticks.
+// CollectDueEntityAi counts the timers down and lists up to capacity
+// wanderers due a new heading; they keep their old one until
+// DecideEntityAi picks it and sets their next timer.
+int CollectDueEntityAi(EntityWorld *world, float dt, Entity *due, int capacity);
+void DecideEntityAi(EntityWorld *world, Entity entity);
+void UpdateEntityMovement(EntityWorld *world, float dt);
+// Advances every sprite's clip by dt, switching between idle and walk by
+// speed. Tool clips play once and then hand back.
+void UpdateEntityAnimation(EntityWorld *world, float dt);
+void PlayEntityClip(EntityWorld *world, Entity entity, AnimClipId clip);
+
+#endif // ENTITY_H_
@@ -0,0 +1,158 @@
+#include "fields.h"
+#include <stdlib.h>
+
+bool InitFieldMap(FieldMap *fields, int width, int height) {
+  *fields = (FieldMap) { .width = width, .height = height };
+  size_t cells = (size_t)width * height;
+
+  fields->parent = malloc(cells * sizeof(*fields->parent));
+  fields->size = calloc(cells, sizeof(*fields->size));
+  fields->queue = malloc(cells * sizeof(*fields->queue));
+  fields->visited = calloc(cells, sizeof(*fields->visited));
+  if (!fields->parent || !fields->size || !fields->queue || !fields->visited) {
+    FreeFieldMap(fields);
+    return false;
+  }
+  for (size_t i = 0; i < cells; i++) {
+    fields->parent[i] = FIELD_NONE;
+  }
+  return true;
+}
+
+void FreeFieldMap(FieldMap *fields) {
+  free(fields->parent);
+  free(fields->size);
+  free(fields->queue);
+  free(fields->visited);
+  *fields = (FieldMap) {0};
+}
+
+bool IsFieldTile(Tile tile) {
+  return tile.type == DIRT && tile.object == OBJECT_NONE;
+}
+
+static int FindRoot(FieldMap *fields, int cell) {
+  // Path halving: every other node on the way up skips to its grandparent
+  while (fields->parent[cell] != cell) {
+    fields->parent[cell] = fields->parent[fields->parent[cell]];
+    cell = fields->parent[cell];
+  }
+  return cell;
+}
+
+static void Union(FieldMap *fields, int a, int b) {
+  a = FindRoot(fields, a);
+  b = FindRoot(fields, b);
+  if (a == b) return;
+
+  if (fields->size[a] < fields->size[b]) {
+    int swap = a;
+    a = b;
+    b = swap;
+  }
+  fields->parent[b] = a;
+  fields->size[a] += fields->size[b];
+  fields->field_count--;
+}
+
+static void AddCell(FieldMap *fields, int x, int y) {
+  int cell = y * fields->width + x;
+  fields->parent[cell] = cell;
+  fields->size[cell] = 1;
+  fields->field_count++;
+
+  if (x > 0 && fields->parent[cell - 1] != FIELD_NONE) Union(fields, cell, cell - 1);
+  if (x < fields->width - 1 && fields->parent[cell + 1] != FIELD_NONE) Union(fields, cell, cell + 1);
+  if (y > 0 && fields->parent[cell - fields->width] != FIELD_NONE) Union(fields, cell, cell - fields->width);
+  if (y < fields->height - 1 && fields->parent[cell + fields->width] != FIELD_NONE) Union(fields, cell, cell + fields->width);
+}
+
+// Gives every tile reachable from start a fresh tree rooted at start
+static void RelabelFrom(FieldMap *fields, int start) {
+  int head = 0;
+  int tail = 0;
+  fields->queue[tail++] = start;
+  fields->visited[start] = fields->visit_epoch;
+
+  while (head < tail) {
+    int cell = fields->queue[head++];
+    fields->parent[cell] = start;
+
+    int x = cell % fields->width;
+    int y = cell / fields->width;
+    int neighbours[4] = {
+      x > 0 ? cell - 1 : -1,
+      x < fields->width - 1 ? cell + 1 : -1,
+      y > 0 ? cell - fields->width : -1,
+      y < fields->height - 1 ? cell + fields->width : -1,
+    };
+    for (int i = 0; i < 4; i++) {
+      int n = neighbours[i];
+      if (n < 0 || fields->parent[n] == FIELD_NONE || fields->visited[n] == fields->visit_epoch) continue;
+      fields->visited[n] = fields->visit_epoch;
+      fields->queue[tail++] = n;
+    }
+  }
+  fields->size[start] = tail;
+  fields->field_count++;
+}
+
+// Every tile of the old field is next to the removed one or connected to
+// a tile that is, so filling out from its neighbours finds all the pieces
+static void RemoveCell(FieldMap *fields, int x, int y) {
+  int cell = y * fields->width + x;
+  fields->parent[cell] = FIELD_NONE;
+  fields->field_count--;  // each piece found below counts again
+
+  fields->visit_epoch++;
+  if (fields->visit_epoch == 0) {
+    for (int i = 0; i < fields->width * fields->height; i++) fields->visited[i] = 0;
+    fields->visit_epoch = 1;
+  }
+
+  int neighbours[4] = {
+    x > 0 ? cell - 1 : -1,
+    x < fields->width - 1 ? cell + 1 : -1,
+    y > 0 ? cell - fields->width : -1,
+    y < fields->height - 1 ? cell + fields->width : -1,
+  };
+  for (int i = 0; i < 4; i++) {
+    int n = neighbours[i];
+    if (n < 0 || fields->parent[n] == FIELD_NONE || fields->visited[n] == fields->visit_epoch) continue;
+    RelabelFrom(fields, n);
+  }
+}
+
+void RebuildFieldMap(FieldMap *fields, Tile tile_map[][MAX_TILE_X]) {
+  fields->field_count = 0;
+  for (int y = 0; y < fields->height; y++) {
+    for (int x = 0; x < fields->width; x++) {
+      fields->parent[y * fields->width + x] = FIELD_NONE;
+    }
+  }
+  for (int y = 0; y < fields->height; y++) {
+    for (int x = 0; x < fields->width; x++) {
+      if (IsFieldTile(tile_map[y][x])) AddCell(fields, x, y);
+    }
+  }
+}
+
+void UpdateFieldTile(FieldMap *fields, int x, int y, Tile tile) {
+  if (x < 0 || y < 0 || x >= fields->width || y >= fields->height) return;
+
+  bool member = fields->parent[y * fields->width + x] != FIELD_NONE;
+  bool should_be = IsFieldTile(tile);
+  if (should_be && !member) AddCell(fields, x, y);
+  if (!should_be && member) RemoveCell(fields, x, y);
+}
+
+int FindField(FieldMap *fields, int x, int y) {
+  if (x < 0 || y < 0 || x >= fields->width || y >= fields->height) return FIELD_NONE;
+  int cell = y * fields->width + x;
+  if (fields->parent[cell] == FIELD_NONE) return FIELD_NONE;
+  return FindRoot(fields, cell);
+}
+
+int GetFieldSize(const FieldMap *fields, int field) {
+  return field == FIELD_NONE ? 0 : fields->size[field];
+}
@@ -0,0 +1,41 @@
+#ifndef FIELDS_H_
+#define FIELDS_H_
+
+#include "game.h"
+#include <stdbool.h>
+
+#define FIELD_NONE (-1)
+
+// Which tilled tiles form one field, kept up to date as tiles change rather
+// than flood filled per query. A tile joining is a union with its
+// neighbours. A tile leaving may split its field, so only that field is
+// walked again and relabelled; the rest of the map is left alone.
+typedef struct FieldMap {
+  int width;
+  int height;
+  int *parent;  // union-find forest, FIELD_NONE for tiles outside any field
+  int *size;    // tiles in the field, valid at roots
+  int field_count;
+
+  // Relabelling after a removal
+  int *queue;
+  unsigned int *visited;  // == visit_epoch when seen this pass
+  unsigned int visit_epoch;
+} FieldMap;
+
+bool InitFieldMap(FieldMap *fields, int width, int height);
+void FreeFieldMap(FieldMap *fields);
+
+// Bare tilled soil; fences and other objects split fields
+bool IsFieldTile(Tile tile);
+
+void RebuildFieldMap(FieldMap *fields, Tile tile_map[][MAX_TILE_X]);
+// Call after the tile at (x, y) changed
+void UpdateFieldTile(FieldMap *fields, int x, int y, Tile tile);
+
+// Id of the field the tile is in, FIELD_NONE if it isn't in one. Ids are
+// only stable until the next update.
+int FindField(FieldMap *fields, int x, int y);
+int GetFieldSize(const FieldMap *fields, int field);
+
+#endif // FIELDS_H_
@@ -0,0 +1,154 @@
+#include "flowfield.h"
+#include <stdlib.h>
+
+// Orthogonal neighbours first so ties prefer straight moves
+static const int NeighbourX[9] = { 0, 1, 0, -1, 1, 1, -1, -1, 0 };
+static const int NeighbourY[9] = { -1, 0, 1, 0, -1, 1, 1, -1, 0 };
+#define DIRECTION_STAY (8)
+
+bool InitFlowFieldCache(FlowFieldCache *cache, int width, int height) {
+  size_t cells = (size_t)width * height;
+  *cache = (FlowFieldCache) {
+    .width = width,
+    .height = height,
+    .queue = malloc(cells * sizeof(int)),
+  };
+  if (!cache->queue) {
+    FreeFlowFieldCache(cache);
+    return false;
+  }
+
+  for (int i = 0; i < FLOW_CACHE_SIZE; i++) {
+    FlowField *field = &cache->fields[i];
+    field->distance = malloc(cells * sizeof(*field->distance));
+    field->direction = malloc(cells * sizeof(*field->direction));
+    if (!field->distance || !field->direction) {
+      FreeFlowFieldCache(cache);
+      return false;
+    }
+  }
+  return true;
+}
+
+void FreeFlowFieldCache(FlowFieldCache *cache) {
+  free(cache->queue);
+  for (int i = 0; i < FLOW_CACHE_SIZE; i++) {
+    free(cache->fields[i].distance);
+    free(cache->fields[i].direction);
+  }
+  *cache = (FlowFieldCache) {0};
+}
+
+static void BuildFlowField(FlowFieldCache *cache, FlowField *field, const WalkGrid *grid) {
+  int width = cache->width;
+  int height = cache->height;
+  unsigned int *distance = field->distance;
+  int *queue = cache->queue;
+
+  for (int i = 0; i < width * height; i++) {
+    distance[i] = FLOW_UNREACHABLE;
+  }
+
+  // Integration field: BFS wavefront out of the target over walkable cells
+  int head = 0;
+  int tail = 0;
+  distance[field->target_y * width + field->target_x] = 0;
+  queue[tail++] = field->target_y * width + field->target_x;
+
+  while (head < tail) {
+    int cell = queue[head++];
+    int x = cell % width;
+    int y = cell / width;
+    for (int n = 0; n < 4; n++) {
+      int nx = x + NeighbourX[n];
+      int ny = y + NeighbourY[n];
+      if (IsCellSolid(grid, nx, ny)) continue;
+      int next = ny * width + nx;
+      if (distance[next] != FLOW_UNREACHABLE) continue;
+      distance[next] = distance[cell] + 1;
+      queue[tail++] = next;
+    }
+  }
+
+  // Flow directions: step to the closest neighbour. Diagonals only when
+  // both sides are open, otherwise agents snag on the corner.
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      int cell = y * width + x;
+      unsigned int best = distance[cell];
+      unsigned char dir = DIRECTION_STAY;
+
+      if (best != FLOW_UNREACHABLE) {
+        for (int n = 0; n < 8; n++) {
+          int nx = x + NeighbourX[n];
+          int ny = y + NeighbourY[n];
+          if (IsCellSolid(grid, nx, ny)) continue;
+          if (n >= 4 && (IsCellSolid(grid, nx, y) || IsCellSolid(grid, x, ny))) continue;
+          unsigned int d = distance[ny * width + nx];
+          if (d < best) {
+            best = d;
+            dir = n;
+          }
+        }
+      }
+      field->direction[cell] = dir;
+    }
+  }
+
+  field->grid_version = grid->version;
+  field->valid = true;
+}
+
+const FlowField *GetFlowField(FlowFieldCache *cache, const WalkGrid *grid, int target_x, int target_y) {
+  if (target_x < 0 || target_y < 0 || target_x >= cache->width || target_y >= cache->height ||
+      IsCellSolid(grid, target_x, target_y)) {
+    return NULL;
+  }
+
+  cache->tick++;
+
+  // Reuse the entry for this target, otherwise evict an empty or the least
+  // recently used one
+  FlowField *victim = NULL;
+  for (int i = 0; i < FLOW_CACHE_SIZE; i++) {
+    FlowField *field = &cache->fields[i];
+    if (field->valid && field->target_x == target_x && field->target_y == target_y) {
+      if (field->grid_version != grid->version) {
+        BuildFlowField(cache, field, grid);
+      }
+      field->last_used = cache->tick;
+      return field;
+    }
+    if (!victim || (victim->valid && (!field->valid || field->last_used < victim->last_used))) {
+      victim = field;
+    }
+  }
+
+  victim->target_x = target_x;
+  victim->target_y = target_y;
+  BuildFlowField(cache, victim, grid);
+  victim->last_used = cache->tick;
+  return victim;
+}
+
+Vector2 SampleFlowField(const FlowFieldCache *cache, const FlowField *field, int x, int y) {
+  if (!field || x < 0 || y < 0 || x >= cache->width || y >= cache->height) {
+    return (Vector2) { 0.f, 0.f };
+  }
+  int dir = field->direction[y * cache->width + x];
+  return (Vector2) { NeighbourX[dir], NeighbourY[dir] };
+}
+
+void FollowFlowField(EntityWorld *world, const FlowFieldCache *cache, const FlowField *field, AiKind kind) {
+  TransformComponents *tr = &world->transform;
+  VelocityComponents *vel = &world->velocity;
+
+  for (int i = 0; i < world->count; i++) {
+    if (world->ai.kind[i] != kind) continue;
+
+    Vector2 dir = SampleFlowField(cache, field, tr->cell_x[i], tr->cell_y[i]);
+    vel->dir_x[i] = dir.x;
+    vel->dir_y[i] = dir.y;
+    vel->current_accel[i] = vel->base_accel[i];
+  }
+}
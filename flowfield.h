@@ -0,0 +1,47 @@
+#ifndef FLOWFIELD_H_
+#define FLOWFIELD_H_
+
+#include "external/raylib-5.5/src/raylib.h"
+#include "entity.h"
+#include "walkgrid.h"
+#include <stdbool.h>
+
+#define FLOW_CACHE_SIZE (4)
+#define FLOW_UNREACHABLE (0xFFFFFFFFu)
+
+// Distance to one target cell for every tile, plus the direction each tile
+// should move in. Built once with a BFS wavefront and shared by any number
+// of agents heading to the same target.
+typedef struct FlowField {
+  int target_x;
+  int target_y;
+  unsigned int grid_version;  // WalkGrid version this was built against
+  unsigned int last_used;
+  bool valid;
+
+  unsigned int *distance;     // width * height, FLOW_UNREACHABLE if cut off
+  unsigned char *direction;   // index into the 8 neighbours, 8 = stay
+} FlowField;
+
+typedef struct FlowFieldCache {
+  int width;
+  int height;
+  unsigned int tick;
+  int *queue;
+  FlowField fields[FLOW_CACHE_SIZE];
+} FlowFieldCache;
+
+bool InitFlowFieldCache(FlowFieldCache *cache, int width, int height);
+void FreeFlowFieldCache(FlowFieldCache *cache);
+
+// Returns the field towards target, rebuilding it only when it isn't cached
+// or a tile changed since it was built. NULL when the target is solid.
+const FlowField *GetFlowField(FlowFieldCache *cache, const WalkGrid *grid, int target_x, int target_y);
+
+// Direction to move from cell (x, y), each axis in -1..1 like player input
+Vector2 SampleFlowField(const FlowFieldCache *cache, const FlowField *field, int x, int y);
+
+// Points every entity of the given AI kind along field
+void FollowFlowField(EntityWorld *world, const FlowFieldCache *cache, const FlowField *field, AiKind kind);
+
+#endif // FLOWFIELD_H_
@@ -0,0 +1,57 @@
+#ifndef GAME_H_
+#define GAME_H_
+
+#include <stdbool.h>
+
+#define TILE_SIZE (50)
+#define MAX_TILE_X (128)
+#define MAX_TILE_Y (128)
+#define FPS (60)
+
+typedef enum LayerType {
+  GROUND,
+  FARM,
+  LAYER_COUNT
+} LayerType;
+
+typedef enum TextureType {
+  EMPTY,
+  GRASS,
+  DIRT,
+  WATER,
+  HILL,
+  PLAYER,
+  CHICKEN,
+  COW,
+  PLAYER_ACTIONS,
+  TEXTURE_TYPE_COUNT,
+} TextureType;
+
+typedef enum ObjectType {
+  OBJECT_NONE,
+  OBJECT_FENCE,
+  OBJECT_CHEST,
+  OBJECT_TREE,
+  OBJECT_TYPE_COUNT,
+} ObjectType;
+
+typedef enum CropType {
+  CROP_NONE,
+  CROP_WHEAT,
+  CROP_TOMATO,
+  CROP_TYPE_COUNT,
+} CropType;
+
+typedef struct Tile {
+  float posX;
+  float posY;
+  TextureType type;
+  ObjectType object;
+  // Crops are never ticked, see crop.h
+  CropType crop;
+  unsigned int crop_planted;
+  bool crop_watered;
+  unsigned char moisture;  // written by the irrigation front, see irrigation.h
+} Tile;
+
+#endif // GAME_H_
@@ -0,0 +1,172 @@
+#include "headless.h"
+#include "sim.h"
+#include "replay.h"
+#include "jobs.h"
+#include <stdio.h>
+
+#define WANDER_TICKS (1800)
+#define CROWD_TICKS (600)
+#define CROWD_ANIMALS (3000)
+
+typedef struct SceneStats {
+  int ticks;
+  double total_ms;
+  double worst_ms;
+} SceneStats;
+
+// Scripted stand-in for a player: fills in this tick's input
+typedef void (*SceneScript)(int tick, SimInput *input, InputEvent *events, int *event_count);
+
+static Simulation sim;
+
+static bool BeginScene(unsigned int seed) {
+  if (!InitSimulation(&sim)) {
+    TraceLog(LOG_ERROR, "Could not allocate the simulation");
+    return false;
+  }
+  SetRandomSeed(seed);
+  if (!BuildFarmScene(&sim.state, seed)) {
+    TraceLog(LOG_ERROR, "Could not generate the world");
+    FreeSimulation(&sim);
+    return false;
+  }
+  return true;
+}
+
+static void Tick(SceneStats *stats, SimInput input, const InputEvent *events, int event_count) {
+  double ms = TickSimulation(&sim, input, events, event_count);
+  stats->ticks++;
+  stats->total_ms += ms;
+  if (ms > stats->worst_ms) stats->worst_ms = ms;
+}
+
+static void ReportScene(const char *name, SceneStats stats) {
+  printf("%s: %d ticks, %d entities, %.3f ms/tick, worst %.3f ms\n", name, stats.ticks,
+      sim.state.entities.count, stats.ticks ? stats.total_ms / stats.ticks : 0.0, stats.worst_ms);
+}
+
+static InputEvent WalkToRandomTile(int max_x, int max_y) {
+  return (InputEvent) {
+    .type = INPUT_WALK_TO,
+    .world_pos = { GetRandomValue(0, max_x - 1) * TILE_SIZE + TILE_SIZE / 2, GetRandomValue(0, max_y - 1) * TILE_SIZE + TILE_SIZE / 2 },
+  };
+}
+
+// Walks around in every direction, alternates with routed walks across the
+// clearing, swings tools and tends the field now and then and calls the
+// chickens over
+static void WanderScript(int tick, SimInput *input, InputEvent *events, int *event_count) {
+  int segment = tick / 90;
+  if (segment % 4 != 3) {
+    int dir = segment % 8;
+    static const int dirs[8][2] = { {1,0}, {1,1}, {0,1}, {-1,1}, {-1,0}, {-1,-1}, {0,-1}, {1,-1} };
+    input->direction = (Vector2) { dirs[dir][0], dirs[dir][1] };
+    input->run = segment % 2;
+  }
+  else if (tick % 90 == 0) {
+    events[(*event_count)++] = WalkToRandomTile(30, 15);
+  }
+  if (tick % 240 == 120) {
+    events[(*event_count)++] = (InputEvent) {
+      .type = INPUT_USE_HOE + tick / 240 % 3,
+      .world_pos = { 22 * TILE_SIZE, 4 * TILE_SIZE },
+    };
+  }
+  if (tick % 240 == 200) {
+    events[(*event_count)++] = (InputEvent) {
+      .type = tick / 240 % 2 ? INPUT_PLANT_WHEAT : INPUT_HARVEST,
+      .world_pos = { 23 * TILE_SIZE, 4 * TILE_SIZE },
+    };
+  }
+  if (tick % 600 == 300) {
+    events[(*event_count)++] = (InputEvent) { .type = INPUT_TOGGLE_FOLLOW, .world_pos = { 0, 0 } };
+  }
+  input->debug = segment % 2;
+}
+
+// Thousands of animals on the open ground around the farm, the chickens
+// following the player while it is routed somewhere new every two seconds
+static void CrowdScript(int tick, SimInput *input, InputEvent *events, int *event_count) {
+  (void)input;  // no held keys, the player only walks where it is sent
+  if (tick == 0) {
+    events[(*event_count)++] = (InputEvent) { .type = INPUT_TOGGLE_FOLLOW, .world_pos = { 0, 0 } };
+  }
+  if (tick % 120 == 0) {
+    events[(*event_count)++] = WalkToRandomTile(64, 64);
+  }
+}
+
+static void SpawnCrowd(GameState *state) {
+  EntityWorld *entities = &state->entities;
+  for (int i = 0; i < CROWD_ANIMALS; i++) {
+    int x = GetRandomValue(0, 63);
+    int y = GetRandomValue(0, 63);
+    if (IsTileSolid(state->tile_map[y][x])) continue;
+
+    bool chicken = i % 4 != 0;
+    SpawnEntity(entities, (EntityDesc) {
+      .position = (Vector2) { x * TILE_SIZE, y * TILE_SIZE },
+      .width = chicken ? 32.f : 64.f,
+      .height = chicken ? 32.f : 64.f,
+      .base_accel = chicken ? 60 : 40,
+      .run_accel_modifier = 1,
+      .texture = chicken ? CHICKEN : COW,
+      .ai = AI_WANDER,
+    });
+  }
+}
+
+static void RunScript(const char *name, SceneScript script, int ticks, bool crowd) {
+  if (!BeginScene(WORLD_SEED)) return;
+  if (crowd) SpawnCrowd(&sim.state);
+
+  SceneStats stats = {0};
+  InputEvent events[MAX_INPUT_EVENTS];
+  for (int tick = 0; tick < ticks; tick++) {
+    SimInput input = {0};
+    int event_count = 0;
+    script(tick, &input, events, &event_count);
+    Tick(&stats, input, events, event_count);
+  }
+  ReportScene(name, stats);
+  FreeSimulation(&sim);
+}
+
+static void RunReplay(const char *path) {
+  Replay replay;
+  if (!LoadReplay(&replay, path)) {
+    TraceLog(LOG_WARNING, "Could not load replay %s", path);
+    return;
+  }
+  if (!BeginScene(replay.header.seed)) {
+    FreeReplay(&replay);
+    return;
+  }
+
+  SceneStats stats = {0};
+  SimInput input;
+  InputEvent events[MAX_INPUT_EVENTS];
+  int event_count;
+  while (ReadReplayTick(&replay, &input, events, &event_count)) {
+    Tick(&stats, input, events, event_count);
+  }
+  ReportScene(path, stats);
+  FreeSimulation(&sim);
+  FreeReplay(&replay);
+}
+
+int RunHeadless(int replay_count, char **replay_paths) {
+  SetTraceLogLevel(LOG_WARNING);
+  if (!InitJobSystem(0)) {
+    TraceLog(LOG_WARNING, "Could not start job threads, running single-threaded");
+  }
+
+  for (int i = 0; i < replay_count; i++) {
+    RunReplay(replay_paths[i]);
+  }
+  RunScript("scene wander", WanderScript, WANDER_TICKS, false);
+  RunScript("scene crowd", CrowdScript, CROWD_TICKS, true);
+
+  ShutdownJobSystem();
+  return 0;
+}
@@ -0,0 +1,9 @@
+#ifndef HEADLESS_H_
+#define HEADLESS_H_
+
+// `game --headless [replays...]`: runs the simulation without a window over
+// the given replays and a few scripted stress scenes, printing the cost of
+// a tick for each. Used as the training run for `./nob pgo`.
+int RunHeadless(int replay_count, char **replay_paths);
+
+#endif // HEADLESS_H_
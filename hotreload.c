@@ -0,0 +1,126 @@
+#include "hotreload.h"
+#include <stdalign.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#define WATCH_POLL_MS (100)
+
+static void GetDirectory(const char *path, char *out) {
+  const char *slash = strrchr(path, '/');
+  int length = slash ? (int)(slash - path) : 0;
+  if (length >= WATCHED_DIR_SIZE) length = WATCHED_DIR_SIZE - 1;
+  if (length == 0) {
+    strcpy(out, ".");
+    return;
+  }
+  memcpy(out, path, length);
+  out[length] = '\0';
+}
+
+static void ReloadChangedFile(HotReloader *reloader, const char *dir, const char *name) {
+  char path[WATCHED_DIR_SIZE + 256];
+  snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+  TextureLoader *loader = reloader->loader;
+  for (int i = 0; i < loader->load_count; i++) {
+    if (strcmp(loader->loads[i].path, path) != 0) continue;
+
+    Image image = LoadImage(path);
+    if (image.data == NULL) {
+      TraceLog(LOG_WARNING, "Could not decode %s, keeping the old texture", path);
+      continue;
+    }
+    if (!QueueTextureReload(loader, i, image)) {
+      TraceLog(LOG_WARNING, "Too many reloads waiting, dropping %s", path);
+      UnloadImage(image);
+    }
+  }
+}
+
+static int HotReloadMain(void *arg) {
+  HotReloader *reloader = arg;
+  // Big enough for several events with names, aligned for the header
+  alignas(struct inotify_event) char buffer[4096];
+
+  while (atomic_load(&reloader->running)) {
+    struct pollfd pfd = { .fd = reloader->fd, .events = POLLIN };
+    if (poll(&pfd, 1, WATCH_POLL_MS) <= 0) continue;
+
+    ssize_t length = read(reloader->fd, buffer, sizeof(buffer));
+    for (ssize_t offset = 0; offset < length; ) {
+      const struct inotify_event *event = (const struct inotify_event *)(buffer + offset);
+      offset += sizeof(struct inotify_event) + event->len;
+      if (event->len == 0) continue;
+
+      for (int i = 0; i < reloader->dir_count; i++) {
+        if (reloader->watches[i] == event->wd) {
+          ReloadChangedFile(reloader, reloader->dirs[i], event->name);
+          break;
+        }
+      }
+    }
+  }
+  return 0;
+}
+
+bool StartHotReload(HotReloader *reloader, TextureLoader *loader) {
+  *reloader = (HotReloader) { .loader = loader };
+  reloader->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (reloader->fd < 0) return false;
+
+  for (int i = 0; i < loader->load_count; i++) {
+    char dir[WATCHED_DIR_SIZE];
+    GetDirectory(loader->loads[i].path, dir);
+
+    bool watched = false;
+    for (int j = 0; j < reloader->dir_count; j++) {
+      if (strcmp(reloader->dirs[j], dir) == 0) watched = true;
+    }
+    if (watched || reloader->dir_count >= MAX_WATCHED_DIRS) continue;
+
+    // Editors either rewrite the file or rename a temporary over it
+    int wd = inotify_add_watch(reloader->fd, dir, IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (wd < 0) continue;
+    reloader->watches[reloader->dir_count] = wd;
+    strcpy(reloader->dirs[reloader->dir_count], dir);
+    reloader->dir_count++;
+  }
+
+  if (reloader->dir_count == 0) {
+    close(reloader->fd);
+    return false;
+  }
+
+  atomic_store(&reloader->running, true);
+  if (thrd_create(&reloader->thread, HotReloadMain, reloader) != thrd_success) {
+    atomic_store(&reloader->running, false);
+    close(reloader->fd);
+    return false;
+  }
+  return true;
+}
+
+void StopHotReload(HotReloader *reloader) {
+  if (!atomic_load(&reloader->running)) return;
+  atomic_store(&reloader->running, false);
+  thrd_join(reloader->thread, NULL);
+  close(reloader->fd);
+}
+
+#else
+
+bool StartHotReload(HotReloader *reloader, TextureLoader *loader) {
+  *reloader = (HotReloader) { .loader = loader };
+  return false;
+}
+
+void StopHotReload(HotReloader *reloader) {
+  (void)reloader;
+}
+
+#endif
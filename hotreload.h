@@ -0,0 +1,30 @@
+#ifndef HOTRELOAD_H_
+#define HOTRELOAD_H_
+
+#include "texload.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <threads.h>
+
+#define MAX_WATCHED_DIRS (16)
+#define WATCHED_DIR_SIZE (128)
+
+// Watches the directories of every loaded texture with inotify and feeds
+// rewritten files back through the loader. Linux only; elsewhere
+// StartHotReload just reports that it isn't available.
+typedef struct HotReloader {
+  TextureLoader *loader;
+  int fd;
+  int watches[MAX_WATCHED_DIRS];
+  char dirs[MAX_WATCHED_DIRS][WATCHED_DIR_SIZE];
+  int dir_count;
+
+  thrd_t thread;
+  atomic_bool running;
+} HotReloader;
+
+// Call once every texture has been requested; later loads aren't watched
+bool StartHotReload(HotReloader *reloader, TextureLoader *loader);
+void StopHotReload(HotReloader *reloader);
+
+#endif // HOTRELOAD_H_
@@ -0,0 +1,118 @@
+#include "impostor.h"
+#include "crop.h"
+#include <limits.h>
+
+_Static_assert(MAX_TEXTURE_LOADS <= 64, "impostors keep a 64 bit mask of texture loads");
+
+void UnloadChunkImpostors(ChunkImpostors *impostors) {
+  for (int cy = 0; cy < SNAPSHOT_CHUNKS_Y; cy++) {
+    for (int cx = 0; cx < SNAPSHOT_CHUNKS_X; cx++) {
+      ChunkImpostor *impostor = &impostors->chunks[cy][cx];
+      if (impostor->target.id != 0) UnloadRenderTexture(impostor->target);
+      *impostor = (ChunkImpostor) {0};
+    }
+  }
+}
+
+static int ChunkEnd(int c, int max) {
+  return (c + 1) * WALK_CHUNK_SIZE < max ? (c + 1) * WALK_CHUNK_SIZE : max;
+}
+
+// Only the textures the impostor was drawn from matter, a swap of any other
+// leaves it as it is
+static bool IsArtStale(const ChunkImpostor *impostor, const TextureLoader *loader) {
+  for (int i = 0; i < loader->load_count; i++) {
+    if ((impostor->art_loads >> i & 1) && impostor->art_versions[i] != loader->loads[i].version) return true;
+  }
+  return false;
+}
+
+static bool IsImpostorStale(const ChunkImpostor *impostor, const RenderSnapshot *snapshot,
+    const TextureLoader *loader, int cx, int cy) {
+  unsigned int below = cy + 1 < SNAPSHOT_CHUNKS_Y ? snapshot->chunk_version[cy + 1][cx] : 0;
+  return !impostor->ready ||
+    impostor->tile_version != snapshot->chunk_version[cy][cx] ||
+    impostor->below_version != below ||
+    snapshot->tick >= impostor->redraw_tick ||
+    IsArtStale(impostor, loader);
+}
+
+static bool RedrawImpostor(ChunkImpostor *impostor, const RenderSnapshot *snapshot,
+    const TextureLoader *loader, int cx, int cy, DrawTilesFn draw, void *ctx) {
+  int size = WALK_CHUNK_SIZE * CHUNK_IMPOSTOR_TEXELS;
+  if (impostor->target.id == 0) {
+    impostor->target = LoadRenderTexture(size, size);
+    if (impostor->target.id == 0) return false;
+  }
+
+  int x0 = cx * WALK_CHUNK_SIZE;
+  int y0 = cy * WALK_CHUNK_SIZE;
+  int x1 = ChunkEnd(cx, MAX_TILE_X);
+  int y1 = ChunkEnd(cy, MAX_TILE_Y);
+
+  BeginTextureMode(impostor->target);
+  ClearBackground(BLANK);
+  BeginMode2D((Camera2D) {
+    .target = { x0 * TILE_SIZE, y0 * TILE_SIZE },
+    .zoom = (float)CHUNK_IMPOSTOR_TEXELS / TILE_SIZE,
+  });
+  // One row more, for the objects standing on it; the rest falls off the edge
+  unsigned long long loads = draw(ctx, x0, y0, x1, y1 < MAX_TILE_Y ? y1 + 1 : y1);
+  EndMode2D();
+  EndTextureMode();
+
+  GenTextureMipmaps(&impostor->target.texture);
+  if (!impostor->ready) SetTextureFilter(impostor->target.texture, TEXTURE_FILTER_TRILINEAR);
+
+  impostor->redraw_tick = ULLONG_MAX;
+  for (int y = y0; y < y1; y++) {
+    for (int x = x0; x < x1; x++) {
+      Tile tile = snapshot->tile_map[y][x];
+      if (tile.crop == CROP_NONE) continue;
+      unsigned long long next = GetCropNextStageTick(tile, snapshot->tick);
+      if (next < impostor->redraw_tick) impostor->redraw_tick = next;
+    }
+  }
+  impostor->tile_version = snapshot->chunk_version[cy][cx];
+  impostor->below_version = cy + 1 < SNAPSHOT_CHUNKS_Y ? snapshot->chunk_version[cy + 1][cx] : 0;
+  impostor->art_loads = loads;
+  for (int i = 0; i < loader->load_count; i++) {
+    impostor->art_versions[i] = loader->loads[i].version;
+  }
+  impostor->ready = true;
+  return true;
+}
+
+int UpdateChunkImpostors(ChunkImpostors *impostors, const RenderSnapshot *snapshot, const TextureLoader *loader,
+    int cx0, int cy0, int cx1, int cy1, DrawTilesFn draw, void *ctx) {
+  int redrawn = 0;
+  for (int cy = cy0; cy < cy1 && redrawn < CHUNK_IMPOSTOR_BUDGET; cy++) {
+    for (int cx = cx0; cx < cx1 && redrawn < CHUNK_IMPOSTOR_BUDGET; cx++) {
+      ChunkImpostor *impostor = &impostors->chunks[cy][cx];
+      if (!IsImpostorStale(impostor, snapshot, loader, cx, cy)) continue;
+      if (RedrawImpostor(impostor, snapshot, loader, cx, cy, draw, ctx)) redrawn++;
+    }
+  }
+  return redrawn;
+}
+
+bool DrawChunkImpostor(const ChunkImpostors *impostors, int cx, int cy) {
+  const ChunkImpostor *impostor = &impostors->chunks[cy][cx];
+  if (!impostor->ready) return false;
+
+  int x0 = cx * WALK_CHUNK_SIZE;
+  int y0 = cy * WALK_CHUNK_SIZE;
+  int width = ChunkEnd(cx, MAX_TILE_X) - x0;
+  int height = ChunkEnd(cy, MAX_TILE_Y) - y0;
+
+  // Render textures are stored bottom up, so the chunk's top rows are at the end
+  Texture2D texture = impostor->target.texture;
+  Rectangle source = {
+    0, texture.height - height * CHUNK_IMPOSTOR_TEXELS,
+    width * CHUNK_IMPOSTOR_TEXELS, -height * CHUNK_IMPOSTOR_TEXELS,
+  };
+  DrawTexturePro(texture, source,
+      (Rectangle) { x0 * TILE_SIZE, y0 * TILE_SIZE, width * TILE_SIZE, height * TILE_SIZE },
+      (Vector2) { 0.0f, 0.0f }, 0.0f, WHITE);
+  return true;
+}
@@ -0,0 +1,51 @@
+#ifndef IMPOSTOR_H_
+#define IMPOSTOR_H_
+
+#include "external/raylib-5.5/src/raylib.h"
+#include "game.h"
+#include "snapshot.h"
+#include "texload.h"
+#include "view.h"
+#include <stdbool.h>
+
+#define CHUNK_IMPOSTOR_TEXELS (ART_TILE_SIZE)  // per tile, the art's own resolution
+#define CHUNK_LOD_ZOOM (0.7f)                  // draw impostors below this camera zoom
+#define CHUNK_IMPOSTOR_BUDGET (8)              // impostors redrawn per frame at most
+
+// Draws the tiles, crops and objects in [x0, x1) x [y0, y1) in world space.
+// Returns a bit per texture load it drew from, by FindTextureLoad index.
+typedef unsigned long long (*DrawTilesFn)(void *ctx, int x0, int y0, int x1, int y1);
+
+typedef struct ChunkImpostor {
+  RenderTexture2D target;  // mipmapped, trilinear
+  bool ready;
+  // What it was drawn from. Objects in the top row of the chunk below poke
+  // up into this one, so that chunk counts too.
+  unsigned int tile_version;
+  unsigned int below_version;
+  unsigned long long art_loads;  // bit per texture load drawn from
+  unsigned int art_versions[MAX_TEXTURE_LOADS];  // of those loads
+  unsigned long long redraw_tick;  // a crop in it shows its next stage
+} ChunkImpostor;
+
+// Zoomed out, each snapshot chunk is drawn as one quad of a picture of its
+// tiles taken earlier, rather than as hundreds of tiles, so the cost of a
+// frame follows the number of chunks on screen instead of the number of
+// tiles. Pictures are taken again only when their chunk's version moves, a
+// crop in it grows or a texture it was drawn from is swapped, and only a
+// few per frame.
+typedef struct ChunkImpostors {
+  ChunkImpostor chunks[SNAPSHOT_CHUNKS_Y][SNAPSHOT_CHUNKS_X];
+} ChunkImpostors;
+
+void UnloadChunkImpostors(ChunkImpostors *impostors);
+
+// Redraws stale impostors of the chunks in [cx0, cx1) x [cy0, cy1). Call
+// outside any BeginTextureMode / BeginMode2D. Returns how many were drawn.
+int UpdateChunkImpostors(ChunkImpostors *impostors, const RenderSnapshot *snapshot, const TextureLoader *loader,
+    int cx0, int cy0, int cx1, int cy1, DrawTilesFn draw, void *ctx);
+
+// False when the chunk has no impostor yet and its tiles have to be drawn
+bool DrawChunkImpostor(const ChunkImpostors *impostors, int cx, int cy);
+
+#endif // IMPOSTOR_H_
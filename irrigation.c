@@ -0,0 +1,123 @@
+#include "irrigation.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool InitIrrigation(Irrigation *irrigation, int width, int height) {
+  *irrigation = (Irrigation) { .width = width, .height = height, .stride = width + 2 };
+  size_t cells = (size_t)(width + 2) * (height + 2);
+
+  irrigation->moisture[0] = calloc(cells, 1);
+  irrigation->moisture[1] = calloc(cells, 1);
+  irrigation->queued = calloc(cells, 1);
+  irrigation->front = malloc(cells * sizeof(int));
+  irrigation->next_front = malloc(cells * sizeof(int));
+  irrigation->changed = malloc(cells * sizeof(int));
+  if (!irrigation->moisture[0] || !irrigation->moisture[1] || !irrigation->queued ||
+      !irrigation->front || !irrigation->next_front || !irrigation->changed) {
+    FreeIrrigation(irrigation);
+    return false;
+  }
+  return true;
+}
+
+void FreeIrrigation(Irrigation *irrigation) {
+  free(irrigation->moisture[0]);
+  free(irrigation->moisture[1]);
+  free(irrigation->queued);
+  free(irrigation->front);
+  free(irrigation->next_front);
+  free(irrigation->changed);
+  *irrigation = (Irrigation) {0};
+}
+
+static void QueueCell(Irrigation *irrigation, int cell) {
+  if (irrigation->queued[cell]) return;
+  irrigation->queued[cell] = 1;
+  irrigation->next_front[irrigation->next_front_count++] = cell;
+}
+
+void ResetIrrigation(Irrigation *irrigation, Tile tile_map[][MAX_TILE_X]) {
+  size_t cells = (size_t)irrigation->stride * (irrigation->height + 2);
+  memset(irrigation->moisture[0], 0, cells);
+  memset(irrigation->moisture[1], 0, cells);
+  memset(irrigation->queued, 0, cells);
+  irrigation->front_count = 0;
+  irrigation->next_front_count = 0;
+  irrigation->changed_count = 0;
+
+  for (int y = 0; y < irrigation->height; y++) {
+    for (int x = 0; x < irrigation->width; x++) {
+      Tile *tile = &tile_map[y][x];
+      int cell = (y + 1) * irrigation->stride + (x + 1);
+      tile->moisture = 0;
+      if (tile->type == WATER) {
+        tile->moisture = MOISTURE_MAX;
+        irrigation->moisture[0][cell] = MOISTURE_MAX;
+        irrigation->moisture[1][cell] = MOISTURE_MAX;
+      }
+      else if (tile->type == DIRT) {
+        QueueCell(irrigation, cell);
+      }
+    }
+  }
+}
+
+void WakeIrrigation(Irrigation *irrigation, int x, int y) {
+  if (x < 0 || y < 0 || x >= irrigation->width || y >= irrigation->height) return;
+  QueueCell(irrigation, (y + 1) * irrigation->stride + (x + 1));
+}
+
+static unsigned char EvaluateCell(const Irrigation *irrigation, const unsigned char *moisture, Tile tile, int cell) {
+  if (tile.type == WATER) return MOISTURE_MAX;
+  if (tile.type != DIRT) return 0;
+
+  int wettest = moisture[cell - 1];
+  if (moisture[cell + 1] > wettest) wettest = moisture[cell + 1];
+  if (moisture[cell - irrigation->stride] > wettest) wettest = moisture[cell - irrigation->stride];
+  if (moisture[cell + irrigation->stride] > wettest) wettest = moisture[cell + irrigation->stride];
+  return wettest > MOISTURE_LOSS ? wettest - MOISTURE_LOSS : 0;
+}
+
+void StepIrrigation(Irrigation *irrigation, Tile tile_map[][MAX_TILE_X]) {
+  // What was queued since the last step is this step's front
+  int *front = irrigation->next_front;
+  int front_count = irrigation->next_front_count;
+  irrigation->next_front = irrigation->front;
+  irrigation->next_front_count = 0;
+  irrigation->front = front;
+  irrigation->front_count = front_count;
+  for (int i = 0; i < front_count; i++) {
+    irrigation->queued[front[i]] = 0;
+  }
+
+  const unsigned char *read = irrigation->moisture[irrigation->current];
+  unsigned char *write = irrigation->moisture[!irrigation->current];
+  int stride = irrigation->stride;
+  irrigation->changed_count = 0;
+
+  for (int i = 0; i < front_count; i++) {
+    int cell = front[i];
+    int x = cell % stride - 1;
+    int y = cell / stride - 1;
+    unsigned char value = EvaluateCell(irrigation, read, tile_map[y][x], cell);
+    if (value == read[cell]) continue;
+
+    write[cell] = value;
+    irrigation->changed[irrigation->changed_count++] = cell;
+
+    // Only the neighbours can be affected, the border cells never are
+    if (x > 0) QueueCell(irrigation, cell - 1);
+    if (x < irrigation->width - 1) QueueCell(irrigation, cell + 1);
+    if (y > 0) QueueCell(irrigation, cell - stride);
+    if (y < irrigation->height - 1) QueueCell(irrigation, cell + stride);
+  }
+
+  // The buffers only differ where this step wrote; bring the one it read
+  // up to date there and read from the other one next time
+  unsigned char *stale = irrigation->moisture[irrigation->current];
+  for (int i = 0; i < irrigation->changed_count; i++) {
+    int cell = irrigation->changed[i];
+    stale[cell] = write[cell];
+  }
+  irrigation->current = !irrigation->current;
+}
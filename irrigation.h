@@ -0,0 +1,57 @@
+#ifndef IRRIGATION_H_
+#define IRRIGATION_H_
+
+#include "game.h"
+#include <stdbool.h>
+
+#define MOISTURE_MAX (255)
+#define MOISTURE_LOSS (40)          // lost per tile of soil the water seeps through
+#define IRRIGATED_MOISTURE (100)    // crops on soil this wet grow as if watered
+
+// Water seeping from water tiles through tilled soil, as a cellular
+// automaton: a soil tile holds the wettest neighbour minus MOISTURE_LOSS,
+// water tiles are always full and everything else stays dry.
+//
+// Only the front is stepped. A tile is looked at again when one of its
+// neighbours changed on the previous step (or the map changed under it), so
+// a settled field, and any chunk without a cell on the front, costs nothing.
+// Reads come from one buffer and writes go to the other, so a step sees the
+// whole front as it was at the start of the step.
+typedef struct Irrigation {
+  int width;
+  int height;
+  int stride;                  // width + 2, with a dry border all round
+  unsigned char *moisture[2];
+  int current;                 // buffer the next step reads
+
+  int *front;                  // padded cell indices to step next
+  int front_count;
+  int *next_front;
+  int next_front_count;
+  unsigned char *queued;       // already on next_front
+
+  int *changed;                // cells the last step changed, padded indices
+  int changed_count;
+} Irrigation;
+
+bool InitIrrigation(Irrigation *irrigation, int width, int height);
+void FreeIrrigation(Irrigation *irrigation);
+
+// Starts over from the map: water full, everything else dry, all soil on the front
+void ResetIrrigation(Irrigation *irrigation, Tile tile_map[][MAX_TILE_X]);
+// The tile changed, look at it on the next step
+void WakeIrrigation(Irrigation *irrigation, int x, int y);
+// One step of the front. The tiles whose moisture changed are listed in
+// irrigation->changed; copying it into the map is up to the caller.
+void StepIrrigation(Irrigation *irrigation, Tile tile_map[][MAX_TILE_X]);
+
+static inline unsigned char GetMoisture(const Irrigation *irrigation, int cell) {
+  return irrigation->moisture[irrigation->current][cell];
+}
+
+static inline void GetIrrigationCell(const Irrigation *irrigation, int cell, int *x, int *y) {
+  *x = cell % irrigation->stride - 1;
+  *y = cell / irrigation->stride - 1;
+}
+
+#endif // IRRIGATION_H_
@@ -0,0 +1,417 @@
+#include "jobs.h"
+#include <stdalign.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <threads.h>
+#include <time.h>
+#include <unistd.h>
+
+#define JOB_DEQUE_SIZE (4096)
+#define JOB_DEQUE_MASK (JOB_DEQUE_SIZE - 1)
+#define IDLE_SPINS (64)
+
+typedef struct {
+  Job job;
+  JobCounter *counter;
+} QueuedJob;
+
+struct JobContinuation {
+  JobContinuation *next;
+  JobCounter *counter;
+  int count;
+  Job jobs[];
+};
+
+// A QueuedJob as stored in a deque. Thieves read an entry before they know
+// whether they won it, while the owner may be refilling the slot, so the
+// fields are atomics (relaxed, the deque indices do the ordering).
+typedef struct {
+  _Atomic(JobFunc) func;
+  _Atomic(void *) data;
+  _Atomic(JobCounter *) counter;
+} DequeEntry;
+
+// Chase-Lev deque: the owner pushes and pops at the bottom, other threads
+// steal from the top. Jobs are stored by value, so a slot is only written
+// once the entry in it has been taken.
+typedef struct {
+  alignas(64) atomic_long top;
+  alignas(64) atomic_long bottom;
+  DequeEntry buffer[JOB_DEQUE_SIZE];
+
+  unsigned int rng;
+} JobThread;
+
+static struct {
+  atomic_bool running;
+  int worker_count;
+  thrd_t workers[MAX_JOB_THREADS];
+
+  JobThread *_Atomic threads[MAX_JOB_THREADS];
+  atomic_int thread_count;
+
+  mtx_t sleep_lock;
+  cnd_t wake;
+  atomic_int sleepers;
+} Jobs;
+
+static thread_local int ThreadIndex = -1;
+
+static QueuedJob LoadEntry(DequeEntry *entry) {
+  return (QueuedJob) {
+    .job = {
+      atomic_load_explicit(&entry->func, memory_order_relaxed),
+      atomic_load_explicit(&entry->data, memory_order_relaxed),
+    },
+    .counter = atomic_load_explicit(&entry->counter, memory_order_relaxed),
+  };
+}
+
+static bool DequePush(JobThread *thread, QueuedJob job) {
+  long b = atomic_load_explicit(&thread->bottom, memory_order_relaxed);
+  long t = atomic_load_explicit(&thread->top, memory_order_acquire);
+  if (b - t >= JOB_DEQUE_SIZE) return false;
+
+  DequeEntry *entry = &thread->buffer[b & JOB_DEQUE_MASK];
+  atomic_store_explicit(&entry->func, job.job.func, memory_order_relaxed);
+  atomic_store_explicit(&entry->data, job.job.data, memory_order_relaxed);
+  atomic_store_explicit(&entry->counter, job.counter, memory_order_relaxed);
+  atomic_store_explicit(&thread->bottom, b + 1, memory_order_release);
+  return true;
+}
+
+static bool DequePop(JobThread *thread, QueuedJob *out) {
+  // The store to bottom has to be ordered before the load of top, which
+  // only a seq_cst pair guarantees
+  long b = atomic_load_explicit(&thread->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit(&thread->bottom, b, memory_order_seq_cst);
+  long t = atomic_load_explicit(&thread->top, memory_order_seq_cst);
+
+  if (t > b) {
+    atomic_store_explicit(&thread->bottom, b + 1, memory_order_relaxed);
+    return false;
+  }
+
+  QueuedJob job = LoadEntry(&thread->buffer[b & JOB_DEQUE_MASK]);
+  bool taken = true;
+  if (t == b) {
+    // Last entry, race the thieves for it
+    taken = atomic_compare_exchange_strong_explicit(&thread->top, &t, t + 1,
+        memory_order_seq_cst, memory_order_relaxed);
+    atomic_store_explicit(&thread->bottom, b + 1, memory_order_relaxed);
+  }
+  if (taken) *out = job;
+  return taken;
+}
+
+static bool DequeSteal(JobThread *thread, QueuedJob *out) {
+  long t = atomic_load_explicit(&thread->top, memory_order_seq_cst);
+  long b = atomic_load_explicit(&thread->bottom, memory_order_seq_cst);
+  if (t >= b) return false;
+
+  QueuedJob copy = LoadEntry(&thread->buffer[t & JOB_DEQUE_MASK]);
+  if (!atomic_compare_exchange_strong_explicit(&thread->top, &t, t + 1,
+        memory_order_seq_cst, memory_order_relaxed)) {
+    return false;
+  }
+  *out = copy;
+  return true;
+}
+
+static bool FindJob(QueuedJob *out) {
+  JobThread *self = Jobs.threads[ThreadIndex];
+  if (DequePop(self, out)) return true;
+
+  int count = atomic_load(&Jobs.thread_count);
+  self->rng = self->rng * 1664525u + 1013904223u;
+  int first = (self->rng >> 16) % count;
+  for (int i = 0; i < count; i++) {
+    int victim = (first + i) % count;
+    if (victim == ThreadIndex) continue;
+    JobThread *thread = atomic_load(&Jobs.threads[victim]);
+    if (thread && DequeSteal(thread, out)) return true;
+  }
+  return false;
+}
+
+static void PushJobs(const Job *jobs, int count, JobCounter *counter);
+
+static void ScheduleContinuations(JobContinuation *list) {
+  while (list) {
+    JobContinuation *next = list->next;
+    PushJobs(list->jobs, list->count, list->counter);
+    free(list);
+    list = next;
+  }
+}
+
+static void ExecuteJob(QueuedJob job) {
+  job.job.func(job.job.data);
+  if (!job.counter) return;
+
+  // The waiter may return and reuse the counter as soon as value hits zero,
+  // so finishing holds it until we have detached the continuations. They are
+  // scheduled after letting go, so waiting on the last counter of a chain
+  // also means every counter before it is free.
+  atomic_fetch_add(&job.counter->finishing, 1);
+  if (atomic_fetch_sub(&job.counter->value, 1) != 1) {
+    atomic_fetch_sub(&job.counter->finishing, 1);
+    return;
+  }
+
+  JobContinuation *continuations = atomic_exchange(&job.counter->continuations, NULL);
+  if (continuations) {
+    // Other finishers are at most a couple of instructions from letting go,
+    // unless they were preempted in between, so give up the core meanwhile
+    while (atomic_load(&job.counter->finishing) > 1) {
+      thrd_yield();
+    }
+  }
+  atomic_fetch_sub(&job.counter->finishing, 1);
+  ScheduleContinuations(continuations);
+}
+
+static void PushJobs(const Job *jobs, int count, JobCounter *counter) {
+  if (ThreadIndex < 0) {
+    for (int i = 0; i < count; i++) {
+      ExecuteJob((QueuedJob) { jobs[i], counter });
+    }
+    return;
+  }
+
+  JobThread *self = Jobs.threads[ThreadIndex];
+  for (int i = 0; i < count; i++) {
+    QueuedJob job = { jobs[i], counter };
+    if (!DequePush(self, job)) {
+      // Deque is full, doing the work now is the best back-pressure
+      ExecuteJob(job);
+    }
+  }
+
+  if (atomic_load(&Jobs.sleepers) > 0) {
+    cnd_broadcast(&Jobs.wake);
+  }
+}
+
+static int WorkerMain(void *arg) {
+  ThreadIndex = (int)(intptr_t)arg;
+  int idle = 0;
+
+  while (atomic_load(&Jobs.running)) {
+    QueuedJob job;
+    if (FindJob(&job)) {
+      ExecuteJob(job);
+      idle = 0;
+      continue;
+    }
+
+    if (++idle < IDLE_SPINS) {
+      thrd_yield();
+      continue;
+    }
+
+    // Timed so a wake-up that slips past the sleepers check costs at most 1ms
+    struct timespec until;
+    timespec_get(&until, TIME_UTC);
+    until.tv_nsec += 1000000;
+    if (until.tv_nsec >= 1000000000) {
+      until.tv_sec++;
+      until.tv_nsec -= 1000000000;
+    }
+    mtx_lock(&Jobs.sleep_lock);
+    atomic_fetch_add(&Jobs.sleepers, 1);
+    cnd_timedwait(&Jobs.wake, &Jobs.sleep_lock, &until);
+    atomic_fetch_sub(&Jobs.sleepers, 1);
+    mtx_unlock(&Jobs.sleep_lock);
+  }
+  return 0;
+}
+
+bool RegisterJobThread(void) {
+  if (ThreadIndex >= 0) return true;
+
+  JobThread *thread = aligned_alloc(64, sizeof(JobThread));
+  if (!thread) return false;
+  *thread = (JobThread) {0};
+
+  int index = atomic_fetch_add(&Jobs.thread_count, 1);
+  if (index >= MAX_JOB_THREADS) {
+    atomic_fetch_sub(&Jobs.thread_count, 1);
+    free(thread);
+    return false;
+  }
+  thread->rng = 2654435761u * (index + 1);
+  atomic_store(&Jobs.threads[index], thread);
+  ThreadIndex = index;
+  return true;
+}
+
+bool InitJobSystem(int worker_count) {
+  if (worker_count <= 0) {
+    worker_count = sysconf(_SC_NPROCESSORS_ONLN) - 1;
+  }
+  if (worker_count > MAX_JOB_THREADS / 2) worker_count = MAX_JOB_THREADS / 2;
+  if (worker_count < 0) worker_count = 0;
+
+  if (mtx_init(&Jobs.sleep_lock, mtx_plain) != thrd_success) return false;
+  if (cnd_init(&Jobs.wake) != thrd_success) return false;
+  atomic_store(&Jobs.running, true);
+
+  if (!RegisterJobThread()) return false;
+
+  // Workers need their deques before anyone can steal from them, so all of
+  // them are registered here and each thread picks up its own index.
+  Jobs.worker_count = 0;
+  for (int i = 0; i < worker_count; i++) {
+    JobThread *thread = aligned_alloc(64, sizeof(JobThread));
+    if (!thread) break;
+    *thread = (JobThread) {0};
+
+    int index = atomic_load(&Jobs.thread_count);
+    thread->rng = 2654435761u * (index + 1);
+    atomic_store(&Jobs.threads[index], thread);
+    atomic_fetch_add(&Jobs.thread_count, 1);
+
+    if (thrd_create(&Jobs.workers[i], WorkerMain, (void *)(intptr_t)index) != thrd_success) {
+      atomic_fetch_sub(&Jobs.thread_count, 1);
+      atomic_store(&Jobs.threads[index], NULL);
+      free(thread);
+      break;
+    }
+    Jobs.worker_count++;
+  }
+  return true;
+}
+
+void ShutdownJobSystem(void) {
+  atomic_store(&Jobs.running, false);
+  cnd_broadcast(&Jobs.wake);
+  for (int i = 0; i < Jobs.worker_count; i++) {
+    thrd_join(Jobs.workers[i], NULL);
+  }
+
+  int count = atomic_load(&Jobs.thread_count);
+  for (int i = 0; i < count; i++) {
+    free(atomic_load(&Jobs.threads[i]));
+    atomic_store(&Jobs.threads[i], NULL);
+  }
+  atomic_store(&Jobs.thread_count, 0);
+  Jobs.worker_count = 0;
+
+  cnd_destroy(&Jobs.wake);
+  mtx_destroy(&Jobs.sleep_lock);
+  ThreadIndex = -1;
+}
+
+int GetJobThreadCount(void) {
+  return Jobs.worker_count + 1;
+}
+
+// A dependency's jobs may all be done while the last of them is still
+// letting go of the counter; wait that out before starting the follow-ups
+static void WaitForFinishers(JobCounter *counter) {
+  while (atomic_load(&counter->finishing) > 0) {
+    thrd_yield();
+  }
+}
+
+void RunJobs(const Job *jobs, int count, JobCounter *counter) {
+  if (counter) atomic_fetch_add(&counter->value, count);
+  PushJobs(jobs, count, counter);
+}
+
+void RunJobsAfter(JobCounter *dependency, const Job *jobs, int count, JobCounter *counter) {
+  if (atomic_load(&dependency->value) == 0) {
+    WaitForFinishers(dependency);
+    RunJobs(jobs, count, counter);
+    return;
+  }
+
+  JobContinuation *continuation = malloc(sizeof(*continuation) + count * sizeof(Job));
+  if (!continuation) {
+    // Out of memory: fall back to blocking on the dependency
+    WaitForCounter(dependency);
+    RunJobs(jobs, count, counter);
+    return;
+  }
+  continuation->counter = counter;
+  continuation->count = count;
+  for (int i = 0; i < count; i++) {
+    continuation->jobs[i] = jobs[i];
+  }
+  if (counter) atomic_fetch_add(&counter->value, count);
+
+  continuation->next = atomic_load(&dependency->continuations);
+  while (!atomic_compare_exchange_weak(&dependency->continuations, &continuation->next, continuation)) {
+  }
+
+  // The dependency may have finished while we were linking in, in which
+  // case nobody else is going to release the list
+  if (atomic_load(&dependency->value) == 0) {
+    JobContinuation *continuations = atomic_exchange(&dependency->continuations, NULL);
+    WaitForFinishers(dependency);
+    ScheduleContinuations(continuations);
+  }
+}
+
+void WaitForCounter(JobCounter *counter) {
+  while (atomic_load(&counter->value) > 0 || atomic_load(&counter->finishing) > 0) {
+    QueuedJob job;
+    if (ThreadIndex >= 0 && FindJob(&job)) {
+      ExecuteJob(job);
+    }
+    else {
+      thrd_yield();
+    }
+  }
+}
+
+typedef struct {
+  RangeFunc func;
+  void *ctx;
+  int begin;
+  int end;
+} RangeJob;
+
+static void RunRangeJob(void *data) {
+  RangeJob *range = data;
+  range->func(range->ctx, range->begin, range->end);
+}
+
+void ParallelFor(int begin, int end, int grain, RangeFunc func, void *ctx) {
+  int items = end - begin;
+  if (items <= 0) return;
+  if (grain < 1) grain = 1;
+
+  int threads = GetJobThreadCount();
+  if (ThreadIndex < 0 || threads <= 1 || items <= grain) {
+    func(ctx, begin, end);
+    return;
+  }
+
+  // Around four ranges per thread so threads that finish early can steal
+  enum { MAX_RANGES = MAX_JOB_THREADS * 4 };
+  int per_range = (items + threads * 4 - 1) / (threads * 4);
+  per_range = (per_range + grain - 1) / grain * grain;
+  int range_count = (items + per_range - 1) / per_range;
+  if (range_count > MAX_RANGES) {
+    per_range = (items + MAX_RANGES - 1) / MAX_RANGES;
+    per_range = (per_range + grain - 1) / grain * grain;
+    range_count = (items + per_range - 1) / per_range;
+  }
+
+  RangeJob ranges[MAX_RANGES];
+  Job jobs[MAX_RANGES];
+  for (int i = 0; i < range_count; i++) {
+    int range_begin = begin + i * per_range;
+    int range_end = range_begin + per_range < end ? range_begin + per_range : end;
+    ranges[i] = (RangeJob) { func, ctx, range_begin, range_end };
+    jobs[i] = (Job) { RunRangeJob, &ranges[i] };
+  }
+
+  // Keep the first range for this thread, it would only wait otherwise
+  JobCounter counter = {0};
+  RunJobs(jobs + 1, range_count - 1, &counter);
+  RunRangeJob(&ranges[0]);
+  WaitForCounter(&counter);
+}
@@ -0,0 +1,49 @@
+#ifndef JOBS_H_
+#define JOBS_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define MAX_JOB_THREADS (64)
+
+typedef void (*JobFunc)(void *data);
+typedef void (*RangeFunc)(void *ctx, int begin, int end);
+
+typedef struct JobContinuation JobContinuation;
+
+// Number of jobs still to finish. Jobs queued with RunJobsAfter start once
+// it drops to zero; don't re-arm a counter before that has happened.
+typedef struct JobCounter {
+  atomic_int value;
+  atomic_int finishing;  // threads still inside a job's completion
+  _Atomic(JobContinuation *) continuations;
+} JobCounter;
+
+typedef struct Job {
+  JobFunc func;
+  void *data;
+} Job;
+
+// Starts worker_count threads (0 picks one per core minus the caller) and
+// registers the calling thread. Without it every call below runs inline.
+bool InitJobSystem(int worker_count);
+void ShutdownJobSystem(void);
+int GetJobThreadCount(void);
+
+// Threads other than the one that called InitJobSystem must register
+// before submitting work, so they get their own queue.
+bool RegisterJobThread(void);
+
+// Queues jobs on the calling thread's deque, idle workers steal from it.
+// counter may be NULL for fire-and-forget jobs.
+void RunJobs(const Job *jobs, int count, JobCounter *counter);
+void RunJobsAfter(JobCounter *dependency, const Job *jobs, int count, JobCounter *counter);
+
+// Runs queued jobs on this thread until counter reaches zero
+void WaitForCounter(JobCounter *counter);
+
+// Splits [begin, end) into ranges of at least grain items, starting at
+// multiples of grain from begin, runs them across all threads and waits.
+void ParallelFor(int begin, int end, int grain, RangeFunc func, void *ctx);
+
+#endif // JOBS_H_
@@ -1,44 +1,28 @@
 #include "external/raylib-5.5/src/raylib.h"
 #include "external/raylib-5.5/src/raymath.h"
 #include "external/raylib-5.5/src/rlgl.h"
+#include "game.h"
+#include "entity.h"
+#include "crop.h"
+#include "sim.h"
+#include "snapshot.h"
+#include "jobs.h"
+#include "texload.h"
+#include "hotreload.h"
+#include "replay.h"
+#include "headless.h"
+#include "view.h"
+#include "dynres.h"
+#include "impostor.h"
 #include <math.h>
 #include <stdio.h>
+#include <string.h>
 #include <threads.h>
 
-#define TILE_SIZE (50)
-#define MAX_TILE_X (30)
-#define MAX_TILE_Y (15)
-#define FPS (60)
-
-typedef enum {
-  ENTITY_IDLE,
-  ENTITY_STATE_COUNT
-} EntityState;
-
-typedef enum LayerType {
-  GROUND,
-  FARM,
-  LAYER_COUNT
-} LayerType;
-
-typedef enum TextureType {
-  EMPTY,
-  GRASS,
-  DIRT,
-  PLAYER,
-  TEXTURE_TYPE_COUNT,
-} TextureType;
-
 typedef struct CameraState {
   float scaleFactor;
 } CameraState;
 
-typedef struct Tile {
-  float posX;
-  float posY;
-  TextureType type;
-} Tile;
-
 typedef enum  {
   CENTER,
   NORTH,
@@ -71,43 +55,11 @@ typedef enum  {
 typedef enum {
   TP_TILESET,
   TP_ENTITY,
+  TP_OBJECT,
   TEXTURE_PATHS_COUNT
 } TexturePath;
 
-typedef struct {
-  Vector2 position;
-  int height;
-  int width;
-  Vector2 direction;
-  Vector2 velocity;
-  int frames_counter;
-  int current_frame;
-  Rectangle frame_rect;
-  int base_accel;
-  int current_accel;
-  int run_accel_modifier;
-  Vector2 cell;
-} Player;
-
-typedef struct GameState {
-  Tile tile_map[MAX_TILE_Y][MAX_TILE_X];
-  Player player;
-  int debug;
-} GameState;
-
-
-static const GameState DefaultGameState = {
-  .player = (Player) {
-    .position = (Vector2) { 0.0f, 0.0f },
-    .velocity = (Vector2) { 0.f, 0.f },
-    .base_accel = 200,
-    .run_accel_modifier = 2,
-    .cell = (Vector2) { 0.f, 0.f },
-  },
-  .debug = 0,
-};
-
-TextureType GetTileType(Tile tile_map[MAX_TILE_Y][MAX_TILE_X], int x, int y) {
+TextureType GetTileType(const Tile tile_map[MAX_TILE_Y][MAX_TILE_X], int x, int y) {
   if (x < 0 || y < 0 || x >= MAX_TILE_X || y >= MAX_TILE_Y) {
     return 0; // out of map
   }
@@ -394,7 +346,7 @@ TextureType GetTileType(Tile tile_map[MAX_TILE_Y][MAX_TILE_X], int x, int y) {
 /*    return CENTER;*/
 /*}*/
 
-TileState GetTileState(Tile tileMap[MAX_TILE_Y][MAX_TILE_X], int tileX, int tileY, TextureType self) {
+TileState GetTileState(const Tile tileMap[MAX_TILE_Y][MAX_TILE_X], int tileX, int tileY, TextureType self) {
   for(int i = -2; i > 2; i++) {
     for(int j = -2; j > 2; j++) {
       if(tileY + i < 0 || tileY + j < 0 || tileX + i >= MAX_TILE_X || tileX + j >= MAX_TILE_Y) {
@@ -405,85 +357,318 @@ TileState GetTileState(Tile tileMap[MAX_TILE_Y][MAX_TILE_X], int tileX, int tile
       }
     }
   }
+  return CENTER;
 }
 
-static Rectangle EntityTextures[TEXTURE_TYPE_COUNT][ENTITY_STATE_COUNT] = {
-  [PLAYER] = {
-    [ENTITY_IDLE] = { 0.0f, 0.0f,  32.0f, 32.0f },
-  }
-};
-
 static Rectangle TileTextures[TEXTURE_TYPE_COUNT][TILE_STATE_COUNT] = {
   [GRASS] = {
     [CENTER] = { 16.0f, 16.0f, 16.0f, 16.0f },
   },
+  [DIRT] = {
+    [CENTER] = { 16.0f, 16.0f, 16.0f, 16.0f },
+  },
+  [WATER] = {
+    [CENTER] = { 0.0f, 0.0f, 16.0f, 16.0f },
+  },
+  [HILL] = {
+    [CENTER] = { 16.0f, 16.0f, 16.0f, 16.0f },
+  },
 };
 
-static char* TexturePaths[][16] = {
+static Rectangle ObjectTextures[OBJECT_TYPE_COUNT] = {
+  [OBJECT_FENCE] = { 0.0f, 48.0f, 16.0f, 16.0f },
+  [OBJECT_CHEST] = { 8.0f, 8.0f, 32.0f, 32.0f },
+  [OBJECT_TREE] = { 0.0f, 0.0f, 16.0f, 32.0f },
+};
+
+// Basic_Plants.png: a row per crop, seeds first, then the growth stages
+static Rectangle CropTextures[CROP_TYPE_COUNT][CROP_STAGE_COUNT] = {
+  [CROP_WHEAT] = {
+    { 16.0f, 0.0f, 16.0f, 16.0f }, { 32.0f, 0.0f, 16.0f, 16.0f },
+    { 48.0f, 0.0f, 16.0f, 16.0f }, { 64.0f, 0.0f, 16.0f, 16.0f },
+  },
+  [CROP_TOMATO] = {
+    { 16.0f, 16.0f, 16.0f, 16.0f }, { 32.0f, 16.0f, 16.0f, 16.0f },
+    { 48.0f, 16.0f, 16.0f, 16.0f }, { 64.0f, 16.0f, 16.0f, 16.0f },
+  },
+};
+
+// Zoomed out, entities are drawn as blocks of colour instead of sprites
+static Color EntityLodColors[TEXTURE_TYPE_COUNT] = {
+  [PLAYER] = { 60, 110, 200, 255 },
+  [CHICKEN] = { 245, 240, 225, 255 },
+  [COW] = { 150, 105, 70, 255 },
+  [PLAYER_ACTIONS] = { 60, 110, 200, 255 },
+};
+
+// Objects taller than a tile stand on their tile and overlap the row above
+static float ObjectTileHeight[OBJECT_TYPE_COUNT] = {
+  [OBJECT_FENCE] = 1.0f,
+  [OBJECT_CHEST] = 1.0f,
+  [OBJECT_TREE] = 2.0f,
+};
+
+static const char* TexturePaths[][16] = {
   [TP_TILESET] = {
     [GRASS] = "Assets/Custom/GrassTile.png",
+    [DIRT] = "Assets/Tilesets/Tilled_Dirt.png",
+    [WATER] = "Assets/Tilesets/Water.png",
+    [HILL] = "Assets/Tilesets/Hills.png",
   },
   [TP_ENTITY] = {
     [PLAYER] = "Assets/Custom/Player.png",
-  }
+    [CHICKEN] = "Assets/Characters/Free Chicken Sprites.png",
+    [COW] = "Assets/Characters/Free Cow Sprites.png",
+    [PLAYER_ACTIONS] = "Assets/Characters/Basic Charakter Actions.png",
+  },
+  [TP_OBJECT] = {
+    [OBJECT_FENCE] = "Assets/Tilesets/Fences.png",
+    [OBJECT_CHEST] = "Assets/Objects/Chest.png",
+    [OBJECT_TREE] = "Assets/Objects/Basic_Grass_Biom_things.png",
+  },
 };
 
-int main() {
+// Irrigated soil is drawn darker the wetter it is
+static Color MoistureTint(unsigned char moisture) {
+  unsigned char shade = 255 - moisture / 3;
+  return (Color) { shade, shade, 255 - moisture / 6, 255 };
+}
+
+// What DrawWorldTiles draws with, and the texture load behind each texture
+typedef struct WorldArt {
+  const RenderSnapshot *snapshot;
+  Texture2D *(*textures)[16];
+  const Texture2D *plants;
+  unsigned long long load_bits[TEXTURE_PATHS_COUNT][16];
+  unsigned long long plants_bit;
+} WorldArt;
+
+static unsigned long long GetTextureLoadBit(const TextureLoader *loader, const Texture2D *texture) {
+  int index = FindTextureLoad(loader, texture);
+  return index < 0 ? 0 : 1ull << index;
+}
+
+// A DrawTilesFn, for the view and for chunk impostors alike
+static unsigned long long DrawWorldTiles(void *ctx, int x0, int y0, int x1, int y1) {
+  const WorldArt *art = ctx;
+  const RenderSnapshot *snapshot = art->snapshot;
+  Texture2D *(*textures)[16] = art->textures;
+  unsigned long long loads = 0;
+
+  for (int tileY = y0; tileY < y1; tileY++) {
+    for (int tileX = x0; tileX < x1; tileX++) {
+      const Tile* curTile = &snapshot->tile_map[tileY][tileX];
+
+      // nothing to draw
+      if (curTile->type == 0) continue;
+
+      TileState tile_state = GetTileState(snapshot->tile_map, tileX, tileY, curTile->type);
+      Rectangle src_rect = TileTextures[curTile->type][tile_state];
+
+      DrawTexturePro(
+          *textures[TP_TILESET][curTile->type],
+          src_rect,
+          (Rectangle){
+              .x = curTile->posX, .y = curTile->posY, TILE_SIZE, TILE_SIZE},
+          (Vector2){0.0f, 0.0f}, 0.0f, curTile->type == DIRT ? MoistureTint(curTile->moisture) : WHITE);
+      loads |= art->load_bits[TP_TILESET][curTile->type];
+
+      // Growth is worked out here from the tick, nothing updates crops
+      if (curTile->crop != CROP_NONE) {
+        DrawTexturePro(
+            *art->plants,
+            CropTextures[curTile->crop][GetCropStage(*curTile, snapshot->tick)],
+            (Rectangle){
+                .x = curTile->posX, .y = curTile->posY, TILE_SIZE, TILE_SIZE},
+            (Vector2){0.0f, 0.0f}, 0.0f, WHITE);
+        loads |= art->plants_bit;
+      }
+    }
+  }
+
+  // Objects go on top of every tile so tall ones aren't covered by the next row
+  for (int tileY = y0; tileY < y1; tileY++) {
+    for (int tileX = x0; tileX < x1; tileX++) {
+      const Tile* curTile = &snapshot->tile_map[tileY][tileX];
+      if (curTile->object == OBJECT_NONE) continue;
+
+      float height = ObjectTileHeight[curTile->object] * TILE_SIZE;
+      DrawTexturePro(
+          *textures[TP_OBJECT][curTile->object],
+          ObjectTextures[curTile->object],
+          (Rectangle){
+              .x = curTile->posX, .y = curTile->posY + TILE_SIZE - height, TILE_SIZE, height},
+          (Vector2){0.0f, 0.0f}, 0.0f, WHITE);
+      loads |= art->load_bits[TP_OBJECT][curTile->object];
+    }
+  }
+  return loads;
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1 && strcmp(argv[1], "--headless") == 0) {
+    return RunHeadless(argc - 2, argv + 2);
+  }
+  // `--record file` saves this session's input as a replay
+  const char *recordPath = argc > 2 && strcmp(argv[1], "--record") == 0 ? argv[2] : NULL;
 
   const int screenHeight = 1080;
   const int screenWidth = 1920;
 
   InitWindow(screenWidth, screenHeight, "ALLFARM");
 
-  Texture2D grassTexture = LoadTexture("Assets/Custom/GrassTile.png");
-  Texture2D playerTexture = LoadTexture("Assets/Custom/Player.png");
+  if (!InitJobSystem(0)) {
+    TraceLog(LOG_WARNING, "Could not start job threads, running single-threaded");
+  }
+
+  // Everything starts out as a placeholder and is swapped for the real
+  // texture once it has been decoded in the background and uploaded
+  // Packed images skip the PNG decode entirely, anything missing from the
+  // pack (or no pack at all) falls back to the loose file
+  AssetPack assetPack;
+#ifdef EMBED_ASSETS
+  if (!OpenEmbeddedAssetPack(&assetPack)) {
+    TraceLog(LOG_WARNING, "Embedded asset pack is invalid, loading loose assets");
+  }
+#else
+  if (!OpenAssetPack(&assetPack, ASSET_PACK_PATH)) {
+    TraceLog(LOG_INFO, "No usable %s, loading loose assets (run `./nob pack`)", ASSET_PACK_PATH);
+  }
+#endif
+
+  static TextureLoader textureLoader;
+  if (!InitTextureLoader(&textureLoader, &assetPack)) {
+    TraceLog(LOG_ERROR, "Could not start the texture loader");
+    CloseAssetPack(&assetPack);
+    ShutdownJobSystem();
+    CloseWindow();
+    return 1;
+  }
+
+  Texture2D grassTexture, dirtTexture, waterTexture, hillTexture;
+  Texture2D playerTexture, chickenTexture, cowTexture, playerActionsTexture;
+  Texture2D fenceTexture, chestTexture, treeTexture;
 
   Texture2D *textures[][16] = {
     [TP_TILESET] = {
       [GRASS] = &grassTexture,
+      [DIRT] = &dirtTexture,
+      [WATER] = &waterTexture,
+      [HILL] = &hillTexture,
     },
     [TP_ENTITY] = {
       [PLAYER] = &playerTexture,
+      [CHICKEN] = &chickenTexture,
+      [COW] = &cowTexture,
+      [PLAYER_ACTIONS] = &playerActionsTexture,
+    },
+    [TP_OBJECT] = {
+      [OBJECT_FENCE] = &fenceTexture,
+      [OBJECT_CHEST] = &chestTexture,
+      [OBJECT_TREE] = &treeTexture,
     },
   };
 
-  Texture2D atlas = LoadTexture("Assets/TextureAtlas.png");
-
-  Camera2D camera = {0};
-  CameraState cameraState = {.scaleFactor = 1.0f};
-
-  GameState gameState = DefaultGameState;
-
-  for (int y = 0; y < MAX_TILE_Y; y++) {
-    for (int x = 0; x < MAX_TILE_X; x++) {
-      gameState.tile_map[y][x] = (Tile){
-        .posX = x * TILE_SIZE,
-        .posY = y * TILE_SIZE,
-        .type = 1
-      };
+  for (int layer = 0; layer < TEXTURE_PATHS_COUNT; layer++) {
+    for (int i = 0; i < 16; i++) {
+      if (textures[layer][i] == NULL) continue;
+      LoadTextureAsync(&textureLoader, textures[layer][i], TexturePaths[layer][i]);
     }
   }
 
-  Player* player = &gameState.player;
+  Texture2D atlas;
+  LoadTextureAsync(&textureLoader, &atlas, "Assets/TextureAtlas.png");
+  Texture2D plantsTexture;
+  LoadTextureAsync(&textureLoader, &plantsTexture, "Assets/Objects/Basic_Plants.png");
+  WorldArt worldArt = {
+    .textures = textures,
+    .plants = &plantsTexture,
+    .plants_bit = GetTextureLoadBit(&textureLoader, &plantsTexture),
+  };
+  for (int layer = 0; layer < TEXTURE_PATHS_COUNT; layer++) {
+    for (int i = 0; i < 16; i++) {
+      if (textures[layer][i] == NULL) continue;
+      worldArt.load_bits[layer][i] = GetTextureLoadBit(&textureLoader, textures[layer][i]);
+    }
+  }
 
-  player->frame_rect = (Rectangle) {
-    0.0f, 0.0f, playerTexture.width / 3.f, playerTexture.height
+  Camera2D camera = {0};
+  CameraState cameraState = {.scaleFactor = 1.0f};
+  // P switches the pixel perfect view on and off
+  WorldView worldView = { .pixel_perfect = false, .resolution = 1.0f };
+  // Otherwise the world's resolution follows how long frames take
+  DynamicResolution resolution = {
+    .min_scale = 0.5f,
+    .max_scale = 1.0f,
+    .step = 0.125f,
+    .budget = 1.0f / FPS,
+    .scale = 1.0f,
   };
+  static ChunkImpostors impostors;
+  int debug = 0;
+
+  static Simulation sim;
+  if (!InitSimulation(&sim)) {
+    TraceLog(LOG_ERROR, "Could not allocate entity storage");
+    FreeTextureLoader(&textureLoader);
+    CloseAssetPack(&assetPack);
+    ShutdownJobSystem();
+    CloseWindow();
+    return 1;
+  }
+  GameState *gameState = &sim.state;
+
+  if (!BuildFarmScene(gameState, WORLD_SEED)) {
+    TraceLog(LOG_ERROR, "Could not generate the world");
+    FreeSimulation(&sim);
+    FreeTextureLoader(&textureLoader);
+    CloseAssetPack(&assetPack);
+    ShutdownJobSystem();
+    CloseWindow();
+    return 1;
+  }
 
   camera.rotation = 0.0f;
   camera.zoom = 1.0f;
+  Camera2D viewCamera = camera;
 
   SetTargetFPS(FPS);
   ToggleFullscreen();
 
-  while (!WindowShouldClose()) {
-    player->frames_counter++;
+  static ReplayWriter recorder;
+  if (recordPath) {
+    if (OpenReplayWriter(&recorder, recordPath, WORLD_SEED)) sim.recorder = &recorder;
+    else TraceLog(LOG_WARNING, "Could not open %s for recording", recordPath);
+  }
 
+  if (!StartSimulation(&sim)) {
+    TraceLog(LOG_ERROR, "Could not start the simulation thread");
+    FreeSimulation(&sim);
+    FreeTextureLoader(&textureLoader);
+    CloseAssetPack(&assetPack);
+    ShutdownJobSystem();
+    CloseWindow();
+    return 1;
+  }
+
+  // Edited textures are swapped in while the game keeps running
+  static HotReloader hotReloader;
+#ifndef EMBED_ASSETS
+  if (!StartHotReload(&hotReloader, &textureLoader)) {
+    TraceLog(LOG_INFO, "Asset hot reload is not available");
+  }
+#endif
+
+  while (!WindowShouldClose()) {
+    double frameStart = GetTime();
     if(IsKeyPressed(KEY_G)) {
-      gameState.debug = !gameState.debug;
+      debug = !debug;
+    }
+    if(IsKeyPressed(KEY_P)) {
+      worldView.pixel_perfect = !worldView.pixel_perfect;
     }
 
-    Vector2 mouseWorldPos = GetScreenToWorld2D(GetMousePosition(), camera);
+    Vector2 mouseWorldPos = GetScreenToWorld2D(GetMousePosition(), viewCamera);
 
     float wheel = GetMouseWheelMove();
     if (wheel != 0) {
@@ -494,182 +679,248 @@ int main() {
     }
     if (camera.zoom > 5.0f)
       camera.zoom = 5.0f;
-    if (camera.zoom < 0.5f)
-      camera.zoom = 0.5f;
-
-    // Player
-    Rectangle* player_rect = EntityTextures[PLAYER];
-
-    player->height = 48.f;
-    player->width = 48.f;
-
-    player->current_accel = player->base_accel;
-
-    if(IsKeyDown(KEY_LEFT_SHIFT))
-      player->current_accel *= player->run_accel_modifier;
+    if (camera.zoom < 0.125f)
+      camera.zoom = 0.125f;
 
+    // Input goes to the simulation thread, which picks it up on its next tick
     int input_dirs[4] = {
       IsKeyDown(KEY_A),
       IsKeyDown(KEY_D),
       IsKeyDown(KEY_W),
       IsKeyDown(KEY_S)
     };
-    player->direction.x = input_dirs[1] - input_dirs[0];
-    player->direction.y = input_dirs[3] - input_dirs[2];
-
-    player->velocity.x = Lerp(
-        player->velocity.x,
-        player->direction.x * player->current_accel,
-        GetFrameTime() * 14.0f
-    );
-    player->velocity.y = Lerp(
-        player->velocity.y,
-        player->direction.y * player->current_accel,
-        GetFrameTime() * 14.0f
-    );
-
-    player->position.x += player->velocity.x * GetFrameTime();
-    player->position.y += player->velocity.y * GetFrameTime();
+    SetSimInput(&sim, (SimInput) {
+      .direction = { input_dirs[1] - input_dirs[0], input_dirs[3] - input_dirs[2] },
+      .run = IsKeyDown(KEY_LEFT_SHIFT),
+      .debug = debug,
+    });
+
+    // Debug: toggle a fence on the hovered tile
+    if (debug && IsMouseButtonPressed(MOUSE_BUTTON_LEFT)) {
+      PushInputEvent(&sim, (InputEvent) { INPUT_TOGGLE_FENCE, mouseWorldPos });
+    }
+    // Call the chickens over, or let them roam again
+    if (IsKeyPressed(KEY_F)) {
+      PushInputEvent(&sim, (InputEvent) { INPUT_TOGGLE_FOLLOW, mouseWorldPos });
+    }
+    // Tool swings: hoe, axe, watering can
+    if (IsKeyPressed(KEY_ONE)) {
+      PushInputEvent(&sim, (InputEvent) { INPUT_USE_HOE, mouseWorldPos });
+    }
+    if (IsKeyPressed(KEY_TWO)) {
+      PushInputEvent(&sim, (InputEvent) { INPUT_USE_AXE, mouseWorldPos });
+    }
+    if (IsKeyPressed(KEY_THREE)) {
+      PushInputEvent(&sim, (InputEvent) { INPUT_USE_WATER, mouseWorldPos });
+    }
+    // Sow the hovered tile (till it with the hoe first), harvest it once ripe
+    if (IsKeyPressed(KEY_E)) {
+      PushInputEvent(&sim, (InputEvent) { INPUT_PLANT_WHEAT, mouseWorldPos });
+    }
+    if (IsKeyPressed(KEY_R)) {
+      PushInputEvent(&sim, (InputEvent) { INPUT_PLANT_TOMATO, mouseWorldPos });
+    }
+    if (IsKeyPressed(KEY_Q)) {
+      PushInputEvent(&sim, (InputEvent) { INPUT_HARVEST, mouseWorldPos });
+    }
+    // Right click walks the player to the clicked tile, any key takes over again
+    if (IsMouseButtonPressed(MOUSE_BUTTON_RIGHT)) {
+      PushInputEvent(&sim, (InputEvent) { INPUT_WALK_TO, mouseWorldPos });
+    }
+
+    // Draw one tick behind the simulation, blending towards its latest state
+    const RenderSnapshot *snapshot = AcquireSnapshot(&sim.snapshots);
+    float alpha = Clamp((GetSimClock() - snapshot->time) / SIM_DT, 0.0f, 1.0f);
+    int p = snapshot->player;
+
+    Rectangle player_rect = {0};
+    if (p >= 0) {
+      player_rect = GetRenderEntityRect(&snapshot->entities[p], alpha);
+    }
 
     camera.target = (Vector2) {
-      player->position.x + (player->width / 2.f),
-      player->position.y + (player->height / 2.f)
+      player_rect.x + (player_rect.width / 2.f),
+      player_rect.y + (player_rect.height / 2.f)
     };
 
-    camera.offset = (Vector2) {
-      .x = GetScreenWidth() / 2.f,
-      .y = GetScreenHeight() / 2.f
-    };
+    worldView.resolution = resolution.scale;
+    viewCamera = UpdateWorldView(&worldView, camera);
 
-    // Set player cell
-    player->cell.x = (player->position.x + (player->width / 2.f)) / TILE_SIZE;
-    player->cell.y = (player->position.y + (player->height / 2.f)) / TILE_SIZE;
+    int player_cell_x = floorf(camera.target.x / TILE_SIZE);
+    int player_cell_y = floorf(camera.target.y / TILE_SIZE);
 
     // Calculate world coordinates of the top-left corner of the player hovered cell
     Vector2 player_world_pos = (Vector2){
-      player->cell.x * TILE_SIZE,
-      player->cell.y * TILE_SIZE
+      player_cell_x * TILE_SIZE,
+      player_cell_y * TILE_SIZE
     };
 
+    // Only the tiles on screen, plus a row below for tall objects poking up
+    Vector2 view_min = GetScreenToWorld2D((Vector2) { 0, 0 }, viewCamera);
+    Vector2 view_max = GetScreenToWorld2D((Vector2) { GetScreenWidth(), GetScreenHeight() }, viewCamera);
+    int view_x0 = Clamp(floorf(view_min.x / TILE_SIZE), 0, MAX_TILE_X);
+    int view_y0 = Clamp(floorf(view_min.y / TILE_SIZE), 0, MAX_TILE_Y);
+    int view_x1 = Clamp(floorf(view_max.x / TILE_SIZE) + 1, 0, MAX_TILE_X);
+    int view_y1 = Clamp(floorf(view_max.y / TILE_SIZE) + 2, 0, MAX_TILE_Y);
+    int chunk_x0 = view_x0 / WALK_CHUNK_SIZE;
+    int chunk_y0 = view_y0 / WALK_CHUNK_SIZE;
+    int chunk_x1 = (view_x1 + WALK_CHUNK_SIZE - 1) / WALK_CHUNK_SIZE;
+    int chunk_y1 = (view_y1 + WALK_CHUNK_SIZE - 1) / WALK_CHUNK_SIZE;
+
+    UploadDecodedTextures(&textureLoader, TEXTURE_UPLOAD_BUDGET);
+
+    // Zoomed out far enough, whole chunks are drawn from their impostors and
+    // entities lose their sprites
+    worldArt.snapshot = snapshot;
+    bool chunkLod = viewCamera.zoom < CHUNK_LOD_ZOOM;
+    if (chunkLod) {
+      UpdateChunkImpostors(&impostors, snapshot, &textureLoader,
+          chunk_x0, chunk_y0, chunk_x1, chunk_y1, DrawWorldTiles, &worldArt);
+    }
+
     BeginDrawing();
     ClearBackground(DARKGRAY);
-    BeginMode2D(camera);
-
+    BeginWorldView(&worldView, viewCamera, DARKGRAY);
 
-    for (int tileY = 0; tileY < MAX_TILE_Y; tileY++) {
-      for (int tileX = 0; tileX < MAX_TILE_X; tileX++) {
-        Tile* curTile = &gameState.tile_map[tileY][tileX];
 
-        // nothing to draw
-        if (curTile->type == 0) continue;
-
-        TileState tile_state = GetTileState(gameState.tile_map, tileX, tileY, curTile->type);
-        Rectangle src_rect = TileTextures[curTile->type][tile_state];
-
-        DrawTexturePro(
-            *textures[TP_TILESET][curTile->type],
-            src_rect,
-            (Rectangle){
-                .x = curTile->posX, .y = curTile->posY, TILE_SIZE, TILE_SIZE},
-            (Vector2){0.0f, 0.0f}, 0.0f, WHITE);
+    if (chunkLod) {
+      for (int cy = chunk_y0; cy < chunk_y1; cy++) {
+        for (int cx = chunk_x0; cx < chunk_x1; cx++) {
+          if (DrawChunkImpostor(&impostors, cx, cy)) continue;
+          int x0 = cx * WALK_CHUNK_SIZE;
+          int y0 = cy * WALK_CHUNK_SIZE;
+          DrawWorldTiles(&worldArt, x0, y0,
+              Clamp(x0 + WALK_CHUNK_SIZE, 0, MAX_TILE_X), Clamp(y0 + WALK_CHUNK_SIZE, 0, MAX_TILE_Y));
+        }
       }
     }
+    else {
+      DrawWorldTiles(&worldArt, view_x0, view_y0, view_x1, view_y1);
+    }
 
-    if(gameState.debug) {
-      for (int gridIdx = 0; gridIdx <= MAX_TILE_X * TILE_SIZE;
+    if(debug) {
+      for (int gridIdx = view_x0 * TILE_SIZE; gridIdx <= view_x1 * TILE_SIZE;
            gridIdx += TILE_SIZE) {
-        DrawLine(gridIdx, 0, gridIdx, MAX_TILE_Y * TILE_SIZE, RAYWHITE);
+        DrawLine(gridIdx, view_y0 * TILE_SIZE, gridIdx, view_y1 * TILE_SIZE, RAYWHITE);
       }
-      for (int gridIdx = 0; gridIdx <= MAX_TILE_Y * TILE_SIZE;
+      for (int gridIdx = view_y0 * TILE_SIZE; gridIdx <= view_y1 * TILE_SIZE;
            gridIdx += TILE_SIZE) {
-        DrawLine(0, gridIdx, MAX_TILE_X * TILE_SIZE, gridIdx, RAYWHITE);
+        DrawLine(view_x0 * TILE_SIZE, gridIdx, view_x1 * TILE_SIZE, gridIdx, RAYWHITE);
       }
     }
 
-    // Animate player sprite
-    if(
-        fabsf(player->velocity.x) > 100.f ||
-        fabsf(player->velocity.y) > 100.f)
-    {
-      Texture2D player_texture = *textures[TP_ENTITY][PLAYER];
-
-      int max_velocity = player->base_accel * player->run_accel_modifier;
-      int sprite_fps = 10;
-      if(player->frames_counter >= (
-          FPS /
-          (sprite_fps *
-           (fabsf(player->velocity.x) + fabsf(player->velocity.y)) / max_velocity)
-        )
-      ) {
-        player->frames_counter = 0;
-        player->current_frame++;
-        if(player->current_frame > 2) {
-          player->current_frame = 0;
-        }
-        if(player->velocity.x < 0.f) {
-          player->frame_rect.width = -player_texture.width / 3.f;
-        }
-        else {
-          player->frame_rect.width = player_texture.width / 3.f;
+    if(debug && snapshot->has_flow) {
+      for (int tileY = view_y0; tileY < view_y1; tileY++) {
+        for (int tileX = view_x0; tileX < view_x1; tileX++) {
+          Vector2 flow = snapshot->flow[tileY][tileX];
+          int cx = tileX * TILE_SIZE + TILE_SIZE / 2;
+          int cy = tileY * TILE_SIZE + TILE_SIZE / 2;
+          DrawLine(cx, cy, cx + flow.x * TILE_SIZE / 3, cy + flow.y * TILE_SIZE / 3, SKYBLUE);
         }
-        player->frame_rect.x = player->current_frame * (player_texture.width / 3.f);
+      }
+    }
+
+    if(debug) {
+      for (int i = snapshot->route_next; i < snapshot->route_count; i++) {
+        PathPoint a = snapshot->route[i - 1];
+        PathPoint b = snapshot->route[i];
+        DrawLine(a.x * TILE_SIZE + TILE_SIZE / 2, a.y * TILE_SIZE + TILE_SIZE / 2,
+            b.x * TILE_SIZE + TILE_SIZE / 2, b.y * TILE_SIZE + TILE_SIZE / 2, GREEN);
+      }
+    }
+
+    if (chunkLod) {
+      for (int i = 0; i < snapshot->entity_count; i++) {
+        const RenderEntity *entity = &snapshot->entities[i];
+        DrawRectangleRec(GetRenderEntityRect(entity, alpha), EntityLodColors[entity->texture]);
       }
     }
     else {
-      player->frame_rect.x = 0.f;
+      DrawSnapshotEntities(snapshot, textures[TP_ENTITY], alpha);
     }
 
-    DrawTexturePro(*textures[TP_ENTITY][PLAYER],
-        player->frame_rect,
-        (Rectangle) {
-        .x = player->position.x,
-        .y = player->position.y,
-        player->width,
-        player->height
-        },
-        (Vector2) { 0.0f, 0.0f },
-        0.0f,
-        WHITE
-    );
+    if(debug) {
+      for (int i = 0; i < snapshot->nearby_count; i++) {
+        int e = snapshot->nearby[i];
+        if (e == p) continue;
+        Rectangle rect = GetRenderEntityRect(&snapshot->entities[e], alpha);
+        DrawRectangleLines(rect.x, rect.y, rect.width, rect.height, YELLOW);
+      }
+    }
 
     // PLAYER POS TILE
     if ((player_world_pos.x < MAX_TILE_X * TILE_SIZE && player_world_pos.x >= 0) &&
         (player_world_pos.y < MAX_TILE_Y * TILE_SIZE && player_world_pos.y >= 0)) {
-      Tile *tile = &gameState.tile_map[(int)player->cell.y][(int)player->cell.x];
-      if(gameState.debug) {
-      char buffer[5000];
+      const Tile *tile = &snapshot->tile_map[player_cell_y][player_cell_x];
+      if(debug) {
         DrawRectangle(tile->posX, tile->posY, TILE_SIZE, TILE_SIZE, (Color) { 255, 255 ,255, 50 });
       }
     }
 
-    EndMode2D();
+    EndWorldView(&worldView);
 
-
-    if(gameState.debug) {
-      DrawRectangle(0, 0, 300, 400, (Color) { 0, 0 ,0, 50 });
+    // The overlay is drawn at full resolution on top of the upscaled world
+    if(debug) {
+      DrawRectangle(0, 0, 300, 650 + 50 * snapshot->slice_count, (Color) { 0, 0 ,0, 50 });
       // top left text
       char buffer[5000];
       sprintf(buffer, "player world pos: %.f, %.f", player_world_pos.x,
               player_world_pos.y);
       DrawText(buffer, 10, 50, 20, WHITE);
-      sprintf(buffer, "player cell: %d, %d", (int)player->cell.x,
-          (int)player->cell.y);
+      sprintf(buffer, "player cell: %d, %d", player_cell_x,
+          player_cell_y);
       DrawText(buffer, 10, 100, 20, WHITE);
       sprintf(buffer, "%f", cameraState.scaleFactor);
       DrawText(buffer, 10, 150, 20, WHITE);
-      sprintf(buffer, "pvx: %f", player->velocity.x);
+      sprintf(buffer, "pvx: %f", snapshot->player_velocity.x);
       DrawText(buffer, 10, 200, 20, WHITE);
-      sprintf(buffer, "pvy: %f", player->velocity.y);
+      sprintf(buffer, "pvy: %f", snapshot->player_velocity.y);
       DrawText(buffer, 10, 250, 20, WHITE);
-      sprintf(buffer, "player: current_frame: %d", player->current_frame);
+      sprintf(buffer, "player: clip: %d", snapshot->player_clip);
       DrawText(buffer, 10, 300, 20, WHITE);
-      sprintf(buffer, "player: frames_counter: %d", player->frames_counter);
+      sprintf(buffer, "player: clip frame: %.2f", snapshot->player_clip_frame);
       DrawText(buffer, 10, 350, 20, WHITE);
+      sprintf(buffer, "entities: %d, near player: %d", snapshot->entity_count, snapshot->nearby_count - 1);
+      DrawText(buffer, 10, 400, 20, WHITE);
+      sprintf(buffer, "sim tick %llu: %.2f ms", snapshot->tick, snapshot->step_ms);
+      DrawText(buffer, 10, 450, 20, WHITE);
+      sprintf(buffer, "irrigation front: %d tiles", snapshot->irrigation_front);
+      DrawText(buffer, 10, 500, 20, WHITE);
+      sprintf(buffer, "fields: %d, this one: %d tiles", snapshot->field_count, snapshot->player_field_size);
+      DrawText(buffer, 10, 550, 20, WHITE);
+      if (worldView.pixel_perfect && worldView.offscreen) {
+        sprintf(buffer, "view: pixel perfect, x%d%s", worldView.scale, chunkLod ? ", lod" : "");
+      }
+      else {
+        sprintf(buffer, "view: %.1f%% resolution%s", resolution.scale * 100.0f, chunkLod ? ", lod" : "");
+      }
+      DrawText(buffer, 10, 600, 20, WHITE);
+      for (int i = 0; i < snapshot->slice_count; i++) {
+        const SliceStats *slice = &snapshot->slices[i];
+        sprintf(buffer, "%s: %d queued, %d/%d done, %.0f us", slice->name, slice->backlog,
+            slice->items, slice->budget, slice->used_us);
+        DrawText(buffer, 10, 650 + 50 * i, 20, WHITE);
+      }
     }
 
+    float busyTime = GetTime() - frameStart;
     EndDrawing();
+    // The pixel perfect target's size is set by the zoom, leave the scale be.
+    // Zoomed out past it the view is scaled like any other.
+    if (!(worldView.pixel_perfect && worldView.offscreen)) {
+      UpdateDynamicResolution(&resolution, GetFrameTime(), busyTime);
+    }
   }
 
+  StopSimulation(&sim);
+  CloseReplayWriter(&recorder);
+  FreeSimulation(&sim);
+  StopHotReload(&hotReloader);
+  FreeTextureLoader(&textureLoader);
+  CloseAssetPack(&assetPack);
+  ShutdownJobSystem();
+  UnloadChunkImpostors(&impostors);
+  UnloadWorldView(&worldView);
   CloseWindow();
   return 0;
 }
@@ -1,27 +1,397 @@
+// Build script. Usage: ./nob [target] [profile] [args...]
+//
+//   game        the game, build/<profile>/game (default target)
+//   embed       the game with assets.pack linked in, build/<profile>/game-embed
+//   pack        packs Assets/ into assets.pack
+//   bench       headless benchmarks, extra args pick which ones
+//   bench-tsan  the benchmarks under ThreadSanitizer
+//   pgo         profile-guided release build, build/pgo/game, trained on
+//               the built-in stress scenes and any replays/*.replay
+//               (recorded with `game --record <file>`)
+//
+// Profiles are debug (default for the game), release, asan and tsan. Every
+// translation unit, raylib's included, gets its own object under
+// build/<profile>/ and is only recompiled when it, a header or this file
+// changed. Compiles run in parallel, one per core.
 #define NOB_IMPLEMENTATION
 #include "nob.h"
 
+#define BUILD_DIR "build"
+
+static char* raylib_path = "./external/raylib-5.5/src/";
+
+typedef struct {
+    const char *name;
+    const char *cflags[8];
+    const char *raylib_cflags[8];  // raylib stays optimised and unsanitised outside release
+} Profile;
+
+static const Profile profiles[] = {
+    { "debug",   { "-Wall", "-Wextra", "-O0", "-g" }, { "-O2", "-g" } },
+    { "release", { "-Wall", "-Wextra", "-O3", "-march=native", "-flto", "-DNDEBUG" }, { "-O3", "-march=native", "-flto", "-DNDEBUG" } },
+    { "asan",    { "-Wall", "-Wextra", "-O1", "-g", "-fno-omit-frame-pointer", "-fsanitize=address,undefined" }, { "-O1", "-g" } },
+    { "tsan",    { "-Wall", "-Wextra", "-O1", "-g", "-fsanitize=thread" }, { "-O1", "-g" } },
+};
+
+static const char *game_sources[] = {
+    "main.c",
+    "entity.c",
+    "anim.c",
+    "crop.c",
+    "timers.c",
+    "irrigation.c",
+    "scheduler.c",
+    "fields.c",
+    "spatial.c",
+    "walkgrid.c",
+    "collision.c",
+    "flowfield.c",
+    "pathfind.c",
+    "jobs.c",
+    "snapshot.c",
+    "sim.c",
+    "queue.c",
+    "worldgen.c",
+    "texload.c",
+    "view.c",
+    "dynres.c",
+    "impostor.c",
+    "assetpack.c",
+    "hotreload.c",
+    "replay.c",
+    "headless.c",
+};
+
+static const char *bench_sources[] = {
+    "bench.c", "entity.c", "anim.c", "timers.c", "walkgrid.c", "pathfind.c", "jobs.c", "queue.c", "worldgen.c",
+};
+
+static const char *pack_sources[] = {
+    "pack.c", "assetpack.c",
+};
+
+static const char *raylib_sources[] = {
+    "rcore.c", "rshapes.c", "rtextures.c", "rtext.c", "rmodels.c", "utils.c", "raudio.c", "rglfw.c",
+};
+
+static const Profile *find_profile(const char *name)
+{
+    for (size_t i = 0; i < NOB_ARRAY_LEN(profiles); i++) {
+        if (strcmp(profiles[i].name, name) == 0) return &profiles[i];
+    }
+    return NULL;
+}
+
+static void append_flags(Nob_Cmd *cmd, const char *const *flags)
+{
+    for (size_t i = 0; i < 8 && flags[i]; i++) nob_cmd_append(cmd, flags[i]);
+}
+
+static void append_system_libs(Nob_Cmd *cmd)
+{
+    nob_cmd_append(cmd, "-lGL", "-lm", "-lpthread", "-ldl", "-lrt", "-lX11");
+}
+
+// Objects depend on their source, every project header and this file,
+// since the flags live here
+static void collect_deps(Nob_File_Paths *deps)
+{
+    Nob_File_Paths children = {0};
+    if (nob_read_entire_dir(".", &children)) {
+        for (size_t i = 0; i < children.count; i++) {
+            if (strcmp(children.items[i], "nob.h") == 0) continue;
+            if (nob_sv_end_with(nob_sv_from_cstr(children.items[i]), ".h")) {
+                nob_da_append(deps, children.items[i]);
+            }
+        }
+    }
+    nob_da_append(deps, "nob.c");
+}
+
+typedef struct {
+    Nob_Procs procs;
+    size_t max_jobs;
+    bool ok;
+} Compiler;
+
+// Waits for whichever running compile finishes first and frees its slot.
+// Nothing else is spawned while compiles run, so any child is one of ours.
+static void wait_for_slot(Compiler *compiler)
+{
+    int wstatus = 0;
+    pid_t pid = waitpid(-1, &wstatus, 0);
+    if (pid < 0) {
+        nob_log(NOB_ERROR, "could not wait on a compile: %s", strerror(errno));
+        compiler->ok = false;
+        compiler->procs.count = 0;
+        return;
+    }
+    if (WIFEXITED(wstatus) && WEXITSTATUS(wstatus) != 0) {
+        nob_log(NOB_ERROR, "command exited with exit code %d", WEXITSTATUS(wstatus));
+        compiler->ok = false;
+    }
+    if (WIFSIGNALED(wstatus)) {
+        nob_log(NOB_ERROR, "command was terminated by %s", strsignal(WTERMSIG(wstatus)));
+        compiler->ok = false;
+    }
+    for (size_t i = 0; i < compiler->procs.count; i++) {
+        if (compiler->procs.items[i] != pid) continue;
+        compiler->procs.items[i] = compiler->procs.items[--compiler->procs.count];
+        break;
+    }
+}
+
+// Starts cmd as soon as fewer than max_jobs compiles are running
+static void compile_async(Compiler *compiler, Nob_Cmd *cmd)
+{
+    while (compiler->procs.count >= compiler->max_jobs) wait_for_slot(compiler);
+    Nob_Proc proc = nob_cmd_run_async_and_reset(cmd);
+    if (proc == NOB_INVALID_PROC) compiler->ok = false;
+    else nob_da_append(&compiler->procs, proc);
+}
+
+// Starts a compile for every source whose object is out of date, and adds
+// every object to objects either way
+static void compile_sources(Compiler *compiler, const char *dir, const char *source_dir,
+                            const char **sources, size_t count,
+                            const char *const *flags, const char **defines, size_t define_count,
+                            const Nob_File_Paths *deps, Nob_File_Paths *objects)
+{
+    if (!nob_mkdir_if_not_exists(dir)) {
+        compiler->ok = false;
+        return;
+    }
+
+    Nob_Cmd cmd = {0};
+    for (size_t i = 0; i < count; i++) {
+        const char *source = nob_temp_sprintf("%s%s", source_dir, sources[i]);
+        const char *object = nob_temp_sprintf("%s/%s.o", dir, sources[i]);
+        nob_da_append(objects, object);
+
+        Nob_File_Paths inputs = {0};
+        nob_da_append(&inputs, source);
+        if (deps) nob_da_append_many(&inputs, deps->items, deps->count);
+        int rebuild = nob_needs_rebuild(object, inputs.items, inputs.count);
+        nob_da_free(inputs);
+        if (rebuild < 0) compiler->ok = false;
+        if (rebuild <= 0) continue;
+
+        nob_cmd_append(&cmd, "cc", "-c", source, "-o", object);
+        append_flags(&cmd, flags);
+        nob_da_append_many(&cmd, defines, define_count);
+        compile_async(compiler, &cmd);
+    }
+    nob_cmd_free(cmd);
+}
+
+// raylib is built from source with the same profile, so release gets LTO
+// across the engine and the game
+static void compile_raylib(Compiler *compiler, const Profile *profile, Nob_File_Paths *objects)
+{
+    const char *defines[] = {
+        "-DPLATFORM_DESKTOP_GLFW", "-DGRAPHICS_API_OPENGL_33", "-D_GNU_SOURCE", "-w",
+        "-I", nob_temp_sprintf("%sexternal/glfw/include", raylib_path),
+    };
+    compile_sources(compiler, nob_temp_sprintf(BUILD_DIR"/%s/raylib", profile->name), raylib_path,
+                    raylib_sources, NOB_ARRAY_LEN(raylib_sources), profile->raylib_cflags,
+                    defines, NOB_ARRAY_LEN(defines), NULL, objects);
+}
+
+// Brings build/<profile>/<name> up to date from sources and raylib.
+// extra_dep, if set, is one more file every object depends on.
+static bool build(const Profile *profile, const char *name, const char **sources, size_t count,
+                  const char **defines, size_t define_count, const char *extra_dep, const char **output)
+{
+    if (!nob_mkdir_if_not_exists(BUILD_DIR)) return false;
+    if (!nob_mkdir_if_not_exists(nob_temp_sprintf(BUILD_DIR"/%s", profile->name))) return false;
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    Compiler compiler = { .max_jobs = cores > 0 ? cores : 1, .ok = true };
+
+    Nob_File_Paths deps = {0};
+    collect_deps(&deps);
+    if (extra_dep) nob_da_append(&deps, extra_dep);
+
+    Nob_File_Paths objects = {0};
+    compile_sources(&compiler, nob_temp_sprintf(BUILD_DIR"/%s/%s.objs", profile->name, name), "",
+                    sources, count, profile->cflags, defines, define_count, &deps, &objects);
+    compile_raylib(&compiler, profile, &objects);
+
+    if (!nob_procs_wait_and_reset(&compiler.procs)) compiler.ok = false;
+    if (!compiler.ok) return false;
+
+    *output = nob_temp_sprintf(BUILD_DIR"/%s/%s", profile->name, name);
+    int relink = nob_needs_rebuild(*output, objects.items, objects.count);
+    if (relink < 0) return false;
+    if (relink == 0) {
+        nob_log(NOB_INFO, "%s is up to date", *output);
+        return true;
+    }
+
+    Nob_Cmd cmd = {0};
+    nob_cmd_append(&cmd, "cc", "-o", *output);
+    append_flags(&cmd, profile->cflags);
+    nob_da_append_many(&cmd, objects.items, objects.count);
+    append_system_libs(&cmd);
+    return nob_cmd_run_sync_and_reset(&cmd);
+}
+
+static bool remove_dir(const char *path)
+{
+    Nob_Cmd cmd = {0};
+    nob_cmd_append(&cmd, "rm", "-rf", path);
+    bool ok = nob_cmd_run_sync(cmd);
+    nob_cmd_free(cmd);
+    return ok;
+}
+
+// Runs binary headless over every recorded replay and the built-in stress
+// scenes, keeping its report in output
+static bool run_headless(const char *binary, const char *output)
+{
+    Nob_Cmd cmd = {0};
+    nob_cmd_append(&cmd, binary, "--headless");
+    Nob_File_Paths replays = {0};
+    if (nob_file_exists("replays") == 1 && nob_read_entire_dir("replays", &replays)) {
+        for (size_t i = 0; i < replays.count; i++) {
+            if (nob_sv_end_with(nob_sv_from_cstr(replays.items[i]), ".replay")) {
+                nob_cmd_append(&cmd, nob_temp_sprintf("replays/%s", replays.items[i]));
+            }
+        }
+    }
+
+    Nob_Fd fd = nob_fd_open_for_write(output);
+    if (fd == NOB_INVALID_FD) return false;
+    bool ok = nob_cmd_run_sync_redirect_and_reset(&cmd, (Nob_Cmd_Redirect) { .fdout = &fd });
+    nob_cmd_free(cmd);
+    return ok;
+}
+
+typedef struct {
+    char name[128];
+    double ms;
+} Timing;
+
+// Pulls "<name>: ... <ms> ms/tick" out of a headless report
+static size_t read_timings(const char *path, Timing *timings, size_t max)
+{
+    Nob_String_Builder sb = {0};
+    if (!nob_read_entire_file(path, &sb)) return 0;
+    nob_sb_append_null(&sb);
+
+    size_t count = 0;
+    for (char *line = strtok(sb.items, "\n"); line && count < max; line = strtok(NULL, "\n")) {
+        char *colon = strstr(line, ": ");
+        char *unit = strstr(line, " ms/tick");
+        if (!colon || !unit || unit < colon) continue;
+
+        char *number = unit;
+        while (number > colon && number[-1] != ' ') number--;
+        snprintf(timings[count].name, sizeof(timings[count].name), "%.*s", (int)(colon - line), line);
+        timings[count].ms = strtod(number, NULL);
+        count++;
+    }
+    nob_sb_free(sb);
+    return count;
+}
+
+// Plain release build for the baseline, then an instrumented build trained
+// on the headless run, then the same objects rebuilt against that profile.
+// Objects keep the same paths across both passes so the counts line up.
+static bool pgo(void)
+{
+    const char *before = BUILD_DIR"/pgo/before.txt";
+    const char *after = BUILD_DIR"/pgo/after.txt";
+    const char *profile_dir = BUILD_DIR"/pgo/profile";
+    const char *output = NULL;
+
+    if (!build(find_profile("release"), "game", game_sources, NOB_ARRAY_LEN(game_sources), NULL, 0, NULL, &output)) return false;
+    if (!nob_mkdir_if_not_exists(BUILD_DIR"/pgo")) return false;
+    if (!run_headless(output, before)) return false;
+
+    Profile generate = {
+        "pgo",
+        { "-Wall", "-Wextra", "-O3", "-march=native", nob_temp_sprintf("-fprofile-generate=%s", profile_dir), "-fprofile-update=atomic" },
+        { "-O3", "-march=native" },
+    };
+    if (!remove_dir(profile_dir) || !remove_dir(BUILD_DIR"/pgo/game.objs")) return false;
+    if (!build(&generate, "game", game_sources, NOB_ARRAY_LEN(game_sources), NULL, 0, NULL, &output)) return false;
+    if (!run_headless(output, BUILD_DIR"/pgo/training.txt")) return false;
+
+    Profile use = {
+        "pgo",
+        { "-Wall", "-Wextra", "-O3", "-march=native", "-flto", nob_temp_sprintf("-fprofile-use=%s", profile_dir), "-fprofile-correction", "-Wno-missing-profile" },
+        { "-O3", "-march=native" },
+    };
+    if (!remove_dir(BUILD_DIR"/pgo/game.objs")) return false;
+    if (!build(&use, "game", game_sources, NOB_ARRAY_LEN(game_sources), NULL, 0, NULL, &output)) return false;
+    if (!run_headless(output, after)) return false;
+
+    Timing baseline[64], optimised[64];
+    size_t baseline_count = read_timings(before, baseline, NOB_ARRAY_LEN(baseline));
+    size_t optimised_count = read_timings(after, optimised, NOB_ARRAY_LEN(optimised));
+    printf("\n%-40s %12s %12s\n", "ms/tick", "release", "pgo");
+    for (size_t i = 0; i < baseline_count && i < optimised_count; i++) {
+        double speedup = optimised[i].ms > 0 ? (baseline[i].ms / optimised[i].ms - 1.0) * 100.0 : 0.0;
+        printf("%-40s %12.3f %12.3f  %+.1f%%\n", baseline[i].name, baseline[i].ms, optimised[i].ms, speedup);
+    }
+    printf("\n%s is ready\n", output);
+    return true;
+}
+
 int main(int argc, char **argv)
 {
     NOB_GO_REBUILD_URSELF(argc, argv);
+    nob_shift_args(&argc, &argv);
+    const char *target = argc > 0 ? nob_shift_args(&argc, &argv) : "game";
+    // `./nob release` is short for `./nob game release`
+    if (find_profile(target)) {
+        argc++;
+        argv--;
+        target = "game";
+    }
+
+    // bench-tsan trades speed for ThreadSanitizer, for the threaded stress tests
+    const char *profile_name = "debug";
+    if (strcmp(target, "bench") == 0) profile_name = "release";
+    if (strcmp(target, "bench-tsan") == 0) profile_name = "tsan";
+    if (argc > 0 && find_profile(argv[0])) profile_name = nob_shift_args(&argc, &argv);
+    const Profile *profile = find_profile(profile_name);
+
     Nob_Cmd cmd = {0};
-    char* raylib_path = "./external/raylib-5.5/src/";
-    nob_cmd_append(
-        &cmd,
-        "cc",
-        "main.c",
-        "-I",
-        raylib_path,
-        "-L",
-        raylib_path,
-        "-lraylib",
-        "-lGL",
-        "-lm",
-        "-lpthread",
-        "-ldl",
-        "-lrt",
-        "-lX11"
-    );
-    if (!nob_cmd_run_sync(cmd)) return 1;
+    const char *output = NULL;
+
+    if (strcmp(target, "bench") == 0 || strcmp(target, "bench-tsan") == 0) {
+        if (!build(profile, "bench", bench_sources, NOB_ARRAY_LEN(bench_sources), NULL, 0, NULL, &output)) return 1;
+
+        nob_cmd_append(&cmd, output);
+        nob_da_append_many(&cmd, argv, argc);
+        if (!nob_cmd_run_sync(cmd)) return 1;
+        return 0;
+    }
+
+    // embed packs the assets first and links the archive into the game, so
+    // the binary runs without an Assets/ directory next to it
+    bool embed = strcmp(target, "embed") == 0;
+    if (strcmp(target, "pack") == 0 || embed) {
+        if (!build(find_profile("release"), "pack", pack_sources, NOB_ARRAY_LEN(pack_sources), NULL, 0, NULL, &output)) return 1;
+
+        nob_cmd_append(&cmd, output);
+        if (!embed) nob_da_append_many(&cmd, argv, argc);
+        if (!nob_cmd_run_sync_and_reset(&cmd)) return 1;
+        if (!embed) return 0;
+
+        const char *defines[] = { "-DEMBED_ASSETS" };
+        if (!build(profile, "game-embed", game_sources, NOB_ARRAY_LEN(game_sources), defines, 1, "assets.pack", &output)) return 1;
+        return 0;
+    }
+
+    if (strcmp(target, "pgo") == 0) return pgo() ? 0 : 1;
+
+    if (strcmp(target, "game") != 0) {
+        nob_log(NOB_ERROR, "unknown target %s", target);
+        return 1;
+    }
+    if (!build(profile, "game", game_sources, NOB_ARRAY_LEN(game_sources), NULL, 0, NULL, &output)) return 1;
     return 0;
 }
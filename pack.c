@@ -0,0 +1,98 @@
+// Decodes every PNG under an asset directory and writes them into one
+// archive the game maps at startup, built and run by `./nob pack`.
+// Usage: pack [asset dir] [output]
+#include "external/raylib-5.5/src/raylib.h"
+#include "assetpack.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+_Static_assert(PACK_PIXEL_FORMAT == PIXELFORMAT_UNCOMPRESSED_R8G8B8A8, "pack pixel format out of sync with raylib");
+
+static int ComparePaths(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static bool WritePadding(FILE *file, long *offset) {
+  static const unsigned char zeros[PACK_ALIGN] = {0};
+  long padding = (PACK_ALIGN - *offset % PACK_ALIGN) % PACK_ALIGN;
+  *offset += padding;
+  return fwrite(zeros, 1, padding, file) == (size_t)padding;
+}
+
+int main(int argc, char **argv) {
+  const char *directory = argc > 1 ? argv[1] : "Assets";
+  const char *output = argc > 2 ? argv[2] : ASSET_PACK_PATH;
+
+  SetTraceLogLevel(LOG_WARNING);
+
+  FilePathList files = LoadDirectoryFilesEx(directory, ".png", true);
+  qsort(files.paths, files.count, sizeof(char *), ComparePaths);
+
+  PackEntry *entries = calloc(files.count, sizeof(PackEntry));
+  if (files.count > 0 && !entries) {
+    fprintf(stderr, "pack: out of memory\n");
+    return 1;
+  }
+
+  FILE *file = fopen(output, "wb");
+  if (!file) {
+    fprintf(stderr, "pack: could not open %s for writing\n", output);
+    return 1;
+  }
+
+  // The index goes in last, once every blob's offset is known
+  long offset = sizeof(PackHeader) + files.count * sizeof(PackEntry);
+  bool ok = fseek(file, offset, SEEK_SET) == 0;
+
+  int count = 0;
+  for (unsigned int i = 0; ok && i < files.count; i++) {
+    const char *path = files.paths[i];
+    if (strlen(path) >= PACK_PATH_SIZE) {
+      fprintf(stderr, "pack: skipping %s, path too long\n", path);
+      continue;
+    }
+
+    Image image = LoadImage(path);
+    if (image.data == NULL) {
+      fprintf(stderr, "pack: skipping %s, could not decode\n", path);
+      continue;
+    }
+    ImageFormat(&image, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8);
+
+    ok = WritePadding(file, &offset);
+    PackEntry *entry = &entries[count++];
+    strcpy(entry->path, path);
+    entry->offset = offset;
+    entry->size = GetPixelDataSize(image.width, image.height, image.format);
+    entry->width = image.width;
+    entry->height = image.height;
+    entry->format = image.format;
+    entry->mipmaps = 1;
+
+    ok = ok && fwrite(image.data, 1, entry->size, file) == entry->size;
+    offset += entry->size;
+    UnloadImage(image);
+  }
+
+  PackHeader header = {
+    .magic = PACK_MAGIC,
+    .version = PACK_VERSION,
+    .entry_count = count,
+  };
+  ok = ok && fseek(file, 0, SEEK_SET) == 0;
+  ok = ok && fwrite(&header, sizeof(header), 1, file) == 1;
+  ok = ok && fwrite(entries, sizeof(PackEntry), count, file) == (size_t)count;
+  ok = fclose(file) == 0 && ok;
+
+  free(entries);
+  UnloadDirectoryFiles(files);
+
+  if (!ok) {
+    fprintf(stderr, "pack: could not write %s\n", output);
+    remove(output);
+    return 1;
+  }
+  printf("pack: %d images, %.1f MB in %s\n", count, offset / (1024.0 * 1024.0), output);
+  return 0;
+}
@@ -0,0 +1,400 @@
+#include "pathfind.h"
+#include <math.h>
+#include <stdlib.h>
+
+#define SQRT2 (1.41421356f)
+
+static inline bool Walkable(const WalkGrid *grid, int x, int y) {
+  return !IsCellSolid(grid, x, y);
+}
+
+static inline int Sign(int v) {
+  return (v > 0) - (v < 0);
+}
+
+static inline float Octile(int x0, int y0, int x1, int y1) {
+  int dx = abs(x1 - x0);
+  int dy = abs(y1 - y0);
+  return dx < dy
+    ? (SQRT2 - 1.f) * dx + dy
+    : (SQRT2 - 1.f) * dy + dx;
+}
+
+bool InitPathfinder(Pathfinder *finder, int width, int height) {
+  size_t cells = (size_t)width * height;
+  *finder = (Pathfinder) {
+    .width = width,
+    .height = height,
+    .g = malloc(cells * sizeof(float)),
+    .parent = malloc(cells * sizeof(int)),
+    .opened = calloc(cells, sizeof(unsigned int)),
+    .closed = calloc(cells, sizeof(unsigned int)),
+    .heap_capacity = 1024,
+    .heap = malloc(1024 * sizeof(PathHeapNode)),
+    .scratch = malloc(cells * sizeof(PathPoint)),
+  };
+  if (!finder->g || !finder->parent || !finder->opened || !finder->closed ||
+      !finder->heap || !finder->scratch) {
+    FreePathfinder(finder);
+    return false;
+  }
+  return true;
+}
+
+void FreePathfinder(Pathfinder *finder) {
+  free(finder->g);
+  free(finder->parent);
+  free(finder->opened);
+  free(finder->closed);
+  free(finder->heap);
+  free(finder->scratch);
+  for (int i = 0; i < PATH_CACHE_SIZE; i++) {
+    free(finder->cache[i].points);
+    free(finder->cache[i].chunks);
+    free(finder->cache[i].chunk_versions);
+  }
+  *finder = (Pathfinder) {0};
+}
+
+static bool HeapPush(Pathfinder *finder, float f, int node) {
+  if (finder->heap_count == finder->heap_capacity) {
+    int capacity = finder->heap_capacity * 2;
+    PathHeapNode *heap = realloc(finder->heap, capacity * sizeof(*heap));
+    if (!heap) return false;
+    finder->heap = heap;
+    finder->heap_capacity = capacity;
+  }
+
+  PathHeapNode *heap = finder->heap;
+  int i = finder->heap_count++;
+  while (i > 0) {
+    int up = (i - 1) / 2;
+    if (heap[up].f <= f) break;
+    heap[i] = heap[up];
+    i = up;
+  }
+  heap[i] = (PathHeapNode) { f, node };
+  return true;
+}
+
+static PathHeapNode HeapPop(Pathfinder *finder) {
+  PathHeapNode *heap = finder->heap;
+  PathHeapNode top = heap[0];
+  PathHeapNode last = heap[--finder->heap_count];
+  int count = finder->heap_count;
+
+  int i = 0;
+  for (;;) {
+    int child = i * 2 + 1;
+    if (child >= count) break;
+    if (child + 1 < count && heap[child + 1].f < heap[child].f) child++;
+    if (heap[child].f >= last.f) break;
+    heap[i] = heap[child];
+    i = child;
+  }
+  if (count > 0) heap[i] = last;
+  return top;
+}
+
+static bool BeginSearch(Pathfinder *finder, const WalkGrid *grid, PathPoint start, PathPoint goal) {
+  if (start.x < 0 || start.y < 0 || start.x >= finder->width || start.y >= finder->height ||
+      goal.x < 0 || goal.y < 0 || goal.x >= finder->width || goal.y >= finder->height ||
+      !Walkable(grid, start.x, start.y) || !Walkable(grid, goal.x, goal.y)) {
+    return false;
+  }
+
+  if (++finder->generation == 0) {
+    // Stamps wrapped around, old ones could look current again
+    for (int i = 0; i < finder->width * finder->height; i++) {
+      finder->opened[i] = 0;
+      finder->closed[i] = 0;
+    }
+    finder->generation = 1;
+  }
+
+  finder->heap_count = 0;
+  int node = start.y * finder->width + start.x;
+  finder->g[node] = 0.f;
+  finder->parent[node] = -1;
+  finder->opened[node] = finder->generation;
+  return HeapPush(finder, Octile(start.x, start.y, goal.x, goal.y), node);
+}
+
+// Walks parents back from goal and writes the route start-first
+static int ReconstructPath(Pathfinder *finder, int goal, PathPoint *out, int max_out) {
+  int count = 0;
+  for (int node = goal; node != -1; node = finder->parent[node]) {
+    count++;
+  }
+  if (count > max_out) return PATH_NOT_FOUND;
+
+  int i = count;
+  for (int node = goal; node != -1; node = finder->parent[node]) {
+    out[--i] = (PathPoint) { node % finder->width, node / finder->width };
+  }
+  return count;
+}
+
+static bool Relax(Pathfinder *finder, int from, int x, int y, PathPoint goal) {
+  int node = y * finder->width + x;
+  if (finder->closed[node] == finder->generation) return true;
+
+  int fx = from % finder->width;
+  int fy = from / finder->width;
+  float g = finder->g[from] + Octile(fx, fy, x, y);
+  if (finder->opened[node] == finder->generation && g >= finder->g[node]) return true;
+
+  finder->opened[node] = finder->generation;
+  finder->g[node] = g;
+  finder->parent[node] = from;
+  return HeapPush(finder, g + Octile(x, y, goal.x, goal.y), node);
+}
+
+static const int NeighbourX[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+static const int NeighbourY[8] = { -1, 0, 1, 0, -1, 1, 1, -1 };
+
+int FindPathAStar(Pathfinder *finder, const WalkGrid *grid, PathPoint start, PathPoint goal, PathPoint *out, int max_out) {
+  if (!BeginSearch(finder, grid, start, goal)) return PATH_NOT_FOUND;
+  int goal_node = goal.y * finder->width + goal.x;
+
+  while (finder->heap_count > 0) {
+    int node = HeapPop(finder).node;
+    if (finder->closed[node] == finder->generation) continue;
+    finder->closed[node] = finder->generation;
+    if (node == goal_node) return ReconstructPath(finder, node, out, max_out);
+
+    int x = node % finder->width;
+    int y = node / finder->width;
+    for (int n = 0; n < 8; n++) {
+      int nx = x + NeighbourX[n];
+      int ny = y + NeighbourY[n];
+      if (!Walkable(grid, nx, ny)) continue;
+      if (n >= 4 && (!Walkable(grid, nx, y) || !Walkable(grid, x, ny))) continue;
+      if (!Relax(finder, node, nx, ny, goal)) return PATH_NOT_FOUND;
+    }
+  }
+  return PATH_NOT_FOUND;
+}
+
+// Jump Point Search for grids where diagonal moves need both sides open.
+// Straight jumps stop next to an obstacle that ends beside them; diagonal
+// jumps stop wherever one of their straight components would.
+static bool JumpStraight(const WalkGrid *grid, int x, int y, int dx, int dy, PathPoint goal, PathPoint *jump) {
+  for (;; x += dx, y += dy) {
+    if (!Walkable(grid, x, y)) return false;
+    if (x == goal.x && y == goal.y) break;
+
+    if (dx != 0) {
+      if ((Walkable(grid, x, y - 1) && !Walkable(grid, x - dx, y - 1)) ||
+          (Walkable(grid, x, y + 1) && !Walkable(grid, x - dx, y + 1))) break;
+    }
+    else {
+      if ((Walkable(grid, x - 1, y) && !Walkable(grid, x - 1, y - dy)) ||
+          (Walkable(grid, x + 1, y) && !Walkable(grid, x + 1, y - dy))) break;
+    }
+  }
+  *jump = (PathPoint) { x, y };
+  return true;
+}
+
+static bool JumpDiagonal(const WalkGrid *grid, int x, int y, int dx, int dy, PathPoint goal, PathPoint *jump) {
+  PathPoint unused;
+  for (;; x += dx, y += dy) {
+    if (!Walkable(grid, x, y)) return false;
+    if (x == goal.x && y == goal.y) break;
+    if (JumpStraight(grid, x + dx, y, dx, 0, goal, &unused) ||
+        JumpStraight(grid, x, y + dy, 0, dy, goal, &unused)) break;
+    if (!Walkable(grid, x + dx, y) || !Walkable(grid, x, y + dy)) return false;
+  }
+  *jump = (PathPoint) { x, y };
+  return true;
+}
+
+static bool Jump(const WalkGrid *grid, int x, int y, int dx, int dy, PathPoint goal, PathPoint *jump) {
+  if (dx != 0 && dy != 0) return JumpDiagonal(grid, x, y, dx, dy, goal, jump);
+  return JumpStraight(grid, x, y, dx, dy, goal, jump);
+}
+
+// Directions worth exploring from (x, y) when arriving along (dx, dy)
+static int PruneNeighbours(const WalkGrid *grid, int x, int y, int dx, int dy, int *dirs_x, int *dirs_y) {
+  int count = 0;
+#define ADD(ddx, ddy) (dirs_x[count] = (ddx), dirs_y[count] = (ddy), count++)
+
+  if (dx == 0 && dy == 0) {
+    for (int n = 0; n < 8; n++) {
+      int nx = x + NeighbourX[n];
+      int ny = y + NeighbourY[n];
+      if (!Walkable(grid, nx, ny)) continue;
+      if (n >= 4 && (!Walkable(grid, nx, y) || !Walkable(grid, x, ny))) continue;
+      ADD(NeighbourX[n], NeighbourY[n]);
+    }
+  }
+  else if (dx != 0 && dy != 0) {
+    bool vertical = Walkable(grid, x, y + dy);
+    bool horizontal = Walkable(grid, x + dx, y);
+    if (vertical) ADD(0, dy);
+    if (horizontal) ADD(dx, 0);
+    if (vertical && horizontal) ADD(dx, dy);
+  }
+  else if (dx != 0) {
+    bool next = Walkable(grid, x + dx, y);
+    bool down = Walkable(grid, x, y + 1);
+    bool up = Walkable(grid, x, y - 1);
+    if (next) {
+      ADD(dx, 0);
+      if (down) ADD(dx, 1);
+      if (up) ADD(dx, -1);
+    }
+    if (down) ADD(0, 1);
+    if (up) ADD(0, -1);
+  }
+  else {
+    bool next = Walkable(grid, x, y + dy);
+    bool right = Walkable(grid, x + 1, y);
+    bool left = Walkable(grid, x - 1, y);
+    if (next) {
+      ADD(0, dy);
+      if (right) ADD(1, dy);
+      if (left) ADD(-1, dy);
+    }
+    if (right) ADD(1, 0);
+    if (left) ADD(-1, 0);
+  }
+
+#undef ADD
+  return count;
+}
+
+int FindPathJps(Pathfinder *finder, const WalkGrid *grid, PathPoint start, PathPoint goal, PathPoint *out, int max_out) {
+  if (!BeginSearch(finder, grid, start, goal)) return PATH_NOT_FOUND;
+  int goal_node = goal.y * finder->width + goal.x;
+
+  while (finder->heap_count > 0) {
+    int node = HeapPop(finder).node;
+    if (finder->closed[node] == finder->generation) continue;
+    finder->closed[node] = finder->generation;
+    if (node == goal_node) return ReconstructPath(finder, node, out, max_out);
+
+    int x = node % finder->width;
+    int y = node / finder->width;
+    int dx = 0;
+    int dy = 0;
+    if (finder->parent[node] != -1) {
+      dx = Sign(x - finder->parent[node] % finder->width);
+      dy = Sign(y - finder->parent[node] / finder->width);
+    }
+
+    int dirs_x[8];
+    int dirs_y[8];
+    int dir_count = PruneNeighbours(grid, x, y, dx, dy, dirs_x, dirs_y);
+    for (int d = 0; d < dir_count; d++) {
+      PathPoint jump;
+      if (!Jump(grid, x + dirs_x[d], y + dirs_y[d], dirs_x[d], dirs_y[d], goal, &jump)) continue;
+      if (!Relax(finder, node, jump.x, jump.y, goal)) return PATH_NOT_FOUND;
+    }
+  }
+  return PATH_NOT_FOUND;
+}
+
+float GetPathLength(const PathPoint *points, int count) {
+  float length = 0.f;
+  for (int i = 1; i < count; i++) {
+    length += Octile(points[i - 1].x, points[i - 1].y, points[i].x, points[i].y);
+  }
+  return length;
+}
+
+static bool ReserveCachedPath(CachedPath *entry, int points, int chunks) {
+  if (points > entry->points_capacity) {
+    PathPoint *p = realloc(entry->points, points * sizeof(*p));
+    if (!p) return false;
+    entry->points = p;
+    entry->points_capacity = points;
+  }
+  if (chunks > entry->chunks_capacity) {
+    int *c = realloc(entry->chunks, chunks * sizeof(*c));
+    if (!c) return false;
+    entry->chunks = c;
+    unsigned int *v = realloc(entry->chunk_versions, chunks * sizeof(*v));
+    if (!v) return false;
+    entry->chunk_versions = v;
+    entry->chunks_capacity = chunks;
+  }
+  return true;
+}
+
+static bool IsCachedPathCurrent(const CachedPath *entry, const WalkGrid *grid) {
+  for (int i = 0; i < entry->chunk_count; i++) {
+    if (grid->chunk_version[entry->chunks[i]] != entry->chunk_versions[i]) return false;
+  }
+  return true;
+}
+
+// Records every chunk the path's cells fall in, walking each segment
+static bool RecordPathChunks(CachedPath *entry, const WalkGrid *grid) {
+  entry->chunk_count = 0;
+  for (int i = 0; i < entry->count; i++) {
+    PathPoint a = entry->points[i];
+    PathPoint b = i + 1 < entry->count ? entry->points[i + 1] : a;
+    int dx = Sign(b.x - a.x);
+    int dy = Sign(b.y - a.y);
+
+    for (int x = a.x, y = a.y;; x += dx, y += dy) {
+      int chunk = GetChunkIndex(grid, x, y);
+      if (entry->chunk_count == 0 || entry->chunks[entry->chunk_count - 1] != chunk) {
+        if (entry->chunk_count == entry->chunks_capacity &&
+            !ReserveCachedPath(entry, 0, entry->chunks_capacity * 2 + 8)) {
+          return false;
+        }
+        entry->chunks[entry->chunk_count] = chunk;
+        entry->chunk_versions[entry->chunk_count] = grid->chunk_version[chunk];
+        entry->chunk_count++;
+      }
+      if (x == b.x && y == b.y) break;
+    }
+  }
+  return true;
+}
+
+const CachedPath *FindPathCached(Pathfinder *finder, const WalkGrid *grid, PathPoint start, PathPoint goal) {
+  int start_node = start.y * finder->width + start.x;
+  int goal_node = goal.y * finder->width + goal.x;
+  unsigned int hash = (unsigned int)start_node * 2654435761u ^ (unsigned int)goal_node * 40503u;
+  CachedPath *set = &finder->cache[(hash % (PATH_CACHE_SIZE / PATH_CACHE_WAYS)) * PATH_CACHE_WAYS];
+  finder->cache_tick++;
+
+  CachedPath *entry = &set[0];
+  for (int way = 0; way < PATH_CACHE_WAYS; way++) {
+    CachedPath *candidate = &set[way];
+    if (candidate->valid && candidate->start == start_node && candidate->goal == goal_node) {
+      if (IsCachedPathCurrent(candidate, grid)) {
+        candidate->last_used = finder->cache_tick;
+        finder->cache_hits++;
+        return candidate;
+      }
+      entry = candidate;
+      break;
+    }
+    if (entry->valid && (!candidate->valid || candidate->last_used < entry->last_used)) {
+      entry = candidate;
+    }
+  }
+  finder->cache_misses++;
+
+  entry->valid = false;
+  int count = FindPathJps(finder, grid, start, goal, finder->scratch, finder->width * finder->height);
+  if (count == PATH_NOT_FOUND) return NULL;
+
+  if (!ReserveCachedPath(entry, count, 0)) return NULL;
+  for (int i = 0; i < count; i++) {
+    entry->points[i] = finder->scratch[i];
+  }
+  entry->count = count;
+  entry->start = start_node;
+  entry->goal = goal_node;
+  if (!RecordPathChunks(entry, grid)) return NULL;
+
+  entry->valid = true;
+  entry->last_used = finder->cache_tick;
+  return entry;
+}
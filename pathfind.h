@@ -0,0 +1,76 @@
+#ifndef PATHFIND_H_
+#define PATHFIND_H_
+
+#include "walkgrid.h"
+#include <stdbool.h>
+
+#define PATH_CACHE_SIZE (1024)
+#define PATH_CACHE_WAYS (4)
+#define PATH_NOT_FOUND (-1)
+
+typedef struct {
+  int x;
+  int y;
+} PathPoint;
+
+typedef struct {
+  float f;
+  int node;
+} PathHeapNode;
+
+// A path kept for reuse, together with the version of every WalkGrid chunk
+// it passes through. An edit in any of those chunks invalidates it.
+typedef struct {
+  bool valid;
+  unsigned int last_used;
+  int start;
+  int goal;
+  PathPoint *points;
+  int count;
+  int points_capacity;
+  int *chunks;
+  unsigned int *chunk_versions;
+  int chunk_count;
+  int chunks_capacity;
+} CachedPath;
+
+// Scratch state for searches over one grid size. Node state is stamped with
+// a search generation instead of being cleared between searches.
+typedef struct Pathfinder {
+  int width;
+  int height;
+  float *g;
+  int *parent;
+  unsigned int *opened;
+  unsigned int *closed;
+  unsigned int generation;
+
+  PathHeapNode *heap;
+  int heap_count;
+  int heap_capacity;
+
+  PathPoint *scratch;
+  // Set associative: a key can live in any of PATH_CACHE_WAYS slots
+  CachedPath cache[PATH_CACHE_SIZE];
+  unsigned int cache_tick;
+  int cache_hits;
+  int cache_misses;
+} Pathfinder;
+
+bool InitPathfinder(Pathfinder *finder, int width, int height);
+void FreePathfinder(Pathfinder *finder);
+
+// Both searches move in 8 directions without cutting corners and write the
+// route from start to goal into out. JPS returns only the jump points (every
+// segment is a straight or diagonal line), A* returns every cell.
+// Return the number of points, or PATH_NOT_FOUND.
+int FindPathJps(Pathfinder *finder, const WalkGrid *grid, PathPoint start, PathPoint goal, PathPoint *out, int max_out);
+int FindPathAStar(Pathfinder *finder, const WalkGrid *grid, PathPoint start, PathPoint goal, PathPoint *out, int max_out);
+
+// JPS through the path cache. The result is owned by the cache and stays
+// valid until the next call. NULL when there is no path.
+const CachedPath *FindPathCached(Pathfinder *finder, const WalkGrid *grid, PathPoint start, PathPoint goal);
+
+float GetPathLength(const PathPoint *points, int count);
+
+#endif // PATHFIND_H_
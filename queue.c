@@ -0,0 +1,115 @@
+#include "queue.h"
+#include <stdlib.h>
+#include <string.h>
+
+static size_t RoundUpPow2(int capacity) {
+  size_t size = 1;
+  while (size < (size_t)capacity) size <<= 1;
+  return size;
+}
+
+bool InitSpscQueue(SpscQueue *queue, int capacity, size_t item_size) {
+  size_t size = RoundUpPow2(capacity);
+  atomic_init(&queue->head, 0);
+  atomic_init(&queue->tail, 0);
+  queue->mask = size - 1;
+  queue->item_size = item_size;
+  queue->items = malloc(size * item_size);
+  return queue->items != NULL;
+}
+
+void FreeSpscQueue(SpscQueue *queue) {
+  free(queue->items);
+  queue->items = NULL;
+}
+
+bool PushSpscQueue(SpscQueue *queue, const void *item) {
+  size_t tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&queue->head, memory_order_acquire);
+  if (tail - head > queue->mask) return false;
+
+  memcpy(queue->items + (tail & queue->mask) * queue->item_size, item, queue->item_size);
+  atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+  return true;
+}
+
+bool PopSpscQueue(SpscQueue *queue, void *out) {
+  size_t head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+  size_t tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+  if (head == tail) return false;
+
+  memcpy(out, queue->items + (head & queue->mask) * queue->item_size, queue->item_size);
+  atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+  return true;
+}
+
+static inline atomic_size_t *SlotSequence(MpscQueue *queue, size_t position) {
+  return (atomic_size_t *)(queue->slots + (position & queue->mask) * queue->slot_size);
+}
+
+static inline unsigned char *SlotItem(MpscQueue *queue, size_t position) {
+  return queue->slots + (position & queue->mask) * queue->slot_size + sizeof(atomic_size_t);
+}
+
+bool InitMpscQueue(MpscQueue *queue, int capacity, size_t item_size) {
+  size_t size = RoundUpPow2(capacity);
+  size_t align = alignof(max_align_t);
+  atomic_init(&queue->tail, 0);
+  queue->head = 0;
+  queue->mask = size - 1;
+  queue->item_size = item_size;
+  queue->slot_size = (sizeof(atomic_size_t) + item_size + align - 1) / align * align;
+  queue->slots = malloc(size * queue->slot_size);
+  if (!queue->slots) return false;
+
+  // Slot i is free for the producer whose position is i
+  for (size_t i = 0; i < size; i++) {
+    atomic_init(SlotSequence(queue, i), i);
+  }
+  return true;
+}
+
+void FreeMpscQueue(MpscQueue *queue) {
+  free(queue->slots);
+  queue->slots = NULL;
+}
+
+bool PushMpscQueue(MpscQueue *queue, const void *item) {
+  size_t position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+  for (;;) {
+    atomic_size_t *sequence = SlotSequence(queue, position);
+    size_t seq = atomic_load_explicit(sequence, memory_order_acquire);
+    ptrdiff_t diff = (ptrdiff_t)(seq - position);
+
+    if (diff == 0) {
+      if (atomic_compare_exchange_weak_explicit(&queue->tail, &position, position + 1,
+            memory_order_relaxed, memory_order_relaxed)) {
+        memcpy(SlotItem(queue, position), item, queue->item_size);
+        atomic_store_explicit(sequence, position + 1, memory_order_release);
+        return true;
+      }
+      // Lost the race, position now holds the current tail
+    }
+    else if (diff < 0) {
+      // The consumer hasn't freed this slot from the previous lap yet
+      return false;
+    }
+    else {
+      position = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    }
+  }
+}
+
+bool PopMpscQueue(MpscQueue *queue, void *out) {
+  size_t position = queue->head;
+  atomic_size_t *sequence = SlotSequence(queue, position);
+  size_t seq = atomic_load_explicit(sequence, memory_order_acquire);
+
+  // Empty, or a producer has claimed the slot but not finished writing it
+  if (seq != position + 1) return false;
+
+  memcpy(out, SlotItem(queue, position), queue->item_size);
+  atomic_store_explicit(sequence, position + queue->mask + 1, memory_order_release);
+  queue->head = position + 1;
+  return true;
+}
@@ -0,0 +1,43 @@
+#ifndef QUEUE_H_
+#define QUEUE_H_
+
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Bounded ring queues that copy fixed-size items in and out. Capacity is
+// rounded up to a power of two. Push fails when the queue is full and Pop
+// when it is empty; neither ever blocks.
+
+// One producer thread, one consumer thread
+typedef struct SpscQueue {
+  alignas(64) atomic_size_t head;  // next slot to pop, written by the consumer
+  alignas(64) atomic_size_t tail;  // next slot to push, written by the producer
+  alignas(64) size_t mask;
+  size_t item_size;
+  unsigned char *items;
+} SpscQueue;
+
+// Any number of producer threads, one consumer thread. Each slot carries a
+// sequence number telling producers and the consumer whose turn it is.
+typedef struct MpscQueue {
+  alignas(64) atomic_size_t tail;  // claimed by producers with a CAS
+  alignas(64) size_t head;         // only touched by the consumer
+  size_t mask;
+  size_t item_size;
+  size_t slot_size;
+  unsigned char *slots;
+} MpscQueue;
+
+bool InitSpscQueue(SpscQueue *queue, int capacity, size_t item_size);
+void FreeSpscQueue(SpscQueue *queue);
+bool PushSpscQueue(SpscQueue *queue, const void *item);
+bool PopSpscQueue(SpscQueue *queue, void *out);
+
+bool InitMpscQueue(MpscQueue *queue, int capacity, size_t item_size);
+void FreeMpscQueue(MpscQueue *queue);
+bool PushMpscQueue(MpscQueue *queue, const void *item);
+bool PopMpscQueue(MpscQueue *queue, void *out);
+
+#endif // QUEUE_H_
@@ -0,0 +1,94 @@
+#include "replay.h"
+#include <stdlib.h>
+#include <string.h>
+
+bool OpenReplayWriter(ReplayWriter *writer, const char *path, unsigned int seed) {
+  *writer = (ReplayWriter) { .seed = seed };
+  writer->file = fopen(path, "wb");
+  if (!writer->file) return false;
+
+  // Rewritten with the real tick count on close
+  ReplayHeader header = { REPLAY_MAGIC, REPLAY_VERSION, seed, 0 };
+  if (fwrite(&header, sizeof(header), 1, writer->file) != 1) {
+    fclose(writer->file);
+    writer->file = NULL;
+    return false;
+  }
+  return true;
+}
+
+void WriteReplayTick(ReplayWriter *writer, SimInput input, const InputEvent *events, int event_count) {
+  if (!writer->file) return;
+
+  ReplayTick tick = {
+    .dir_x = (int8_t)input.direction.x,
+    .dir_y = (int8_t)input.direction.y,
+    .run = input.run,
+    .debug = input.debug,
+    .event_count = event_count,
+  };
+  fwrite(&tick, sizeof(tick), 1, writer->file);
+  fwrite(events, sizeof(InputEvent), event_count, writer->file);
+  writer->tick_count++;
+}
+
+void CloseReplayWriter(ReplayWriter *writer) {
+  if (!writer->file) return;
+
+  ReplayHeader header = { REPLAY_MAGIC, REPLAY_VERSION, writer->seed, writer->tick_count };
+  if (fseek(writer->file, 0, SEEK_SET) == 0) {
+    fwrite(&header, sizeof(header), 1, writer->file);
+  }
+  fclose(writer->file);
+  writer->file = NULL;
+}
+
+bool LoadReplay(Replay *replay, const char *path) {
+  *replay = (Replay) {0};
+
+  int size = 0;
+  unsigned char *data = LoadFileData(path, &size);
+  if (!data) return false;
+
+  if ((size_t)size < sizeof(ReplayHeader)) {
+    UnloadFileData(data);
+    return false;
+  }
+  memcpy(&replay->header, data, sizeof(ReplayHeader));
+  if (replay->header.magic != REPLAY_MAGIC || replay->header.version != REPLAY_VERSION) {
+    UnloadFileData(data);
+    return false;
+  }
+
+  replay->data = data;
+  replay->size = size;
+  replay->cursor = sizeof(ReplayHeader);
+  return true;
+}
+
+void FreeReplay(Replay *replay) {
+  if (replay->data) UnloadFileData(replay->data);
+  *replay = (Replay) {0};
+}
+
+bool ReadReplayTick(Replay *replay, SimInput *input, InputEvent *events, int *event_count) {
+  ReplayTick tick;
+  if (replay->size - replay->cursor < sizeof(tick)) return false;
+  memcpy(&tick, replay->data + replay->cursor, sizeof(tick));
+
+  size_t events_size = (size_t)tick.event_count * sizeof(InputEvent);
+  if (tick.event_count > MAX_INPUT_EVENTS ||
+      replay->size - replay->cursor - sizeof(tick) < events_size) {
+    return false;
+  }
+  memcpy(events, replay->data + replay->cursor + sizeof(tick), events_size);
+  replay->cursor += sizeof(tick) + events_size;
+
+  *input = (SimInput) {
+    .direction = { tick.dir_x, tick.dir_y },
+    .run = tick.run,
+    .debug = tick.debug,
+  };
+  *event_count = tick.event_count;
+  return true;
+}
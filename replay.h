@@ -0,0 +1,58 @@
+#ifndef REPLAY_H_
+#define REPLAY_H_
+
+#include "sim.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Recorded player input, one record per simulation tick:
+//
+//   ReplayHeader | (ReplayTick, InputEvent[event_count])[tick_count]
+//
+// Files are raw structs, only meant to be played back by the same build
+// of the game on the same platform.
+#define REPLAY_MAGIC (0x50524641u)  // "AFRP"
+#define REPLAY_VERSION (1)
+
+typedef struct ReplayHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t seed;  // the world the input was recorded on
+  uint32_t tick_count;
+} ReplayHeader;
+
+typedef struct ReplayTick {
+  int8_t dir_x;
+  int8_t dir_y;
+  uint8_t run;
+  uint8_t debug;
+  uint32_t event_count;
+} ReplayTick;
+
+struct ReplayWriter {
+  FILE *file;
+  uint32_t seed;
+  uint32_t tick_count;
+};
+
+typedef struct Replay {
+  unsigned char *data;
+  size_t size;
+  size_t cursor;
+  ReplayHeader header;
+} Replay;
+
+bool OpenReplayWriter(ReplayWriter *writer, const char *path, unsigned int seed);
+void WriteReplayTick(ReplayWriter *writer, SimInput input, const InputEvent *events, int event_count);
+// Fills in the tick count and closes the file
+void CloseReplayWriter(ReplayWriter *writer);
+
+bool LoadReplay(Replay *replay, const char *path);
+void FreeReplay(Replay *replay);
+// Next tick's input; false at the end or if the file is cut short.
+// events must hold MAX_INPUT_EVENTS.
+bool ReadReplayTick(Replay *replay, SimInput *input, InputEvent *events, int *event_count);
+
+#endif // REPLAY_H_
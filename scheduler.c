@@ -0,0 +1,36 @@
+#include "scheduler.h"
+#include <time.h>
+
+static double GetSliceClock(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+bool AddSlicedSystem(SliceScheduler *scheduler, const char *name, int budget,
+    SliceWorkFn work, SliceBacklogFn backlog, void *ctx) {
+  if (scheduler->count >= MAX_SLICED_SYSTEMS || budget < 1) return false;
+
+  scheduler->systems[scheduler->count++] = (SlicedSystem) {
+    .work = work,
+    .backlog = backlog,
+    .ctx = ctx,
+    .stats = { .name = name, .budget = budget },
+  };
+  return true;
+}
+
+void RunSlicedSystems(SliceScheduler *scheduler) {
+  for (int i = 0; i < scheduler->count; i++) {
+    SlicedSystem *system = &scheduler->systems[i];
+    double start = GetSliceClock();
+    int items = 0;
+    while (items < system->stats.budget && system->work(system->ctx)) {
+      items++;
+    }
+
+    system->stats.items = items;
+    system->stats.used_us = (GetSliceClock() - start) * 1e6;
+    system->stats.backlog = system->backlog(system->ctx);
+  }
+}
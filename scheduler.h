@@ -0,0 +1,42 @@
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <stdbool.h>
+
+#define MAX_SLICED_SYSTEMS (8)
+
+// Does one small unit of work. Returns false when there was nothing to do.
+typedef bool (*SliceWorkFn)(void *ctx);
+// How many units are still waiting
+typedef int (*SliceBacklogFn)(void *ctx);
+
+typedef struct SliceStats {
+  const char *name;
+  int backlog;      // left waiting after the last run
+  int items;        // done in the last run
+  int budget;       // items per run at most
+  float used_us;    // what the last run took, for display only
+} SliceStats;
+
+typedef struct SlicedSystem {
+  SliceWorkFn work;
+  SliceBacklogFn backlog;
+  void *ctx;
+  SliceStats stats;
+} SlicedSystem;
+
+// Work that doesn't have to finish within one tick, spread over as many as
+// it takes. Each run every system does up to its budget of items. Budgets
+// are counts, not time, so what gets done on a tick is the same on every
+// machine and replays play back the same; the time taken is only measured
+// for the debug overlay.
+typedef struct SliceScheduler {
+  SlicedSystem systems[MAX_SLICED_SYSTEMS];
+  int count;
+} SliceScheduler;
+
+bool AddSlicedSystem(SliceScheduler *scheduler, const char *name, int budget,
+    SliceWorkFn work, SliceBacklogFn backlog, void *ctx);
+void RunSlicedSystems(SliceScheduler *scheduler);
+
+#endif // SCHEDULER_H_
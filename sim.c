@@ -0,0 +1,542 @@
+#include "sim.h"
+#include "collision.h"
+#include "crop.h"
+#include "jobs.h"
+#include "replay.h"
+#include "worldgen.h"
+#include <math.h>
+#include <string.h>
+#include <time.h>
+
+// After a stall this long (debugger, window drag) the simulation drops the
+// missed ticks instead of racing to catch up with them.
+#define MAX_SIM_LAG (0.25)
+
+double GetSimClock(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Routes the player to the goal of the latest walk order, from wherever
+// the player is by the time it gets its turn
+static bool RoutePlayer(void *ctx) {
+  GameState *state = ctx;
+  if (!state->route_requested) return false;
+  state->route_requested = false;
+
+  EntityWorld *entities = &state->entities;
+  int p = GetEntityIndex(entities, state->player);
+  if (p < 0) return true;
+
+  Route *route = &state->player_route;
+  PathPoint start = { entities->transform.cell_x[p], entities->transform.cell_y[p] };
+  const CachedPath *path = FindPathCached(&state->pathfinder, &state->walk_grid, start, state->route_goal);
+  route->count = 0;
+  route->next = 1;
+  if (path && path->count <= MAX_ROUTE_POINTS) {
+    for (int i = 0; i < path->count; i++) {
+      route->points[i] = path->points[i];
+    }
+    route->count = path->count;
+  }
+  return true;
+}
+
+static int GetRouteBacklog(void *ctx) {
+  const GameState *state = ctx;
+  return state->route_requested;
+}
+
+static bool DecideNextWanderer(void *ctx) {
+  GameState *state = ctx;
+  if (state->ai_due_head == state->ai_due_count) return false;
+  DecideEntityAi(&state->entities, state->ai_due[state->ai_due_head++]);
+  return true;
+}
+
+static int GetAiBacklog(void *ctx) {
+  const GameState *state = ctx;
+  return state->ai_due_count - state->ai_due_head;
+}
+
+// Counts the wander timers down and queues whoever is due behind the ones
+// still waiting from earlier ticks
+static void QueueDueWanderers(GameState *state, float dt) {
+  int waiting = state->ai_due_count - state->ai_due_head;
+  memmove(state->ai_due, state->ai_due + state->ai_due_head, waiting * sizeof(*state->ai_due));
+  state->ai_due_head = 0;
+  state->ai_due_count = waiting + CollectDueEntityAi(&state->entities, dt,
+      state->ai_due + waiting, MAX_ENTITIES - waiting);
+}
+
+bool InitSimulation(Simulation *sim) {
+  *sim = (Simulation) {0};
+  GameState *state = &sim->state;
+  state->player = ENTITY_NONE;
+
+  // Snapshots start at version 0, so the first one copies every chunk
+  for (int cy = 0; cy < SNAPSHOT_CHUNKS_Y; cy++) {
+    for (int cx = 0; cx < SNAPSHOT_CHUNKS_X; cx++) {
+      state->tile_version[cy][cx] = 1;
+    }
+  }
+
+  if (!InitEntityWorld(&state->entities, MAX_ENTITIES) ||
+      !InitSpatialHash(&state->spatial, MAX_ENTITIES) ||
+      !InitWalkGrid(&state->walk_grid, MAX_TILE_X, MAX_TILE_Y) ||
+      !InitFlowFieldCache(&state->flow_fields, MAX_TILE_X, MAX_TILE_Y) ||
+      !InitPathfinder(&state->pathfinder, MAX_TILE_X, MAX_TILE_Y) ||
+      !InitTimerWheel(&state->timers, MAX_WORLD_TIMERS, 0) ||
+      !InitIrrigation(&state->irrigation, MAX_TILE_X, MAX_TILE_Y) ||
+      !InitFieldMap(&state->fields, MAX_TILE_X, MAX_TILE_Y) ||
+      !InitSnapshotBuffer(&sim->snapshots, MAX_ENTITIES) ||
+      !InitSpscQueue(&sim->input_events, MAX_INPUT_EVENTS, sizeof(InputEvent))) {
+    FreeSimulation(sim);
+    return false;
+  }
+
+  // The simulation lives where it was initialised, so state can be the context
+  AddSlicedSystem(&state->scheduler, "pathfinding", PATHFIND_BUDGET, RoutePlayer, GetRouteBacklog, state);
+  AddSlicedSystem(&state->scheduler, "ai", AI_BUDGET, DecideNextWanderer, GetAiBacklog, state);
+  return true;
+}
+
+void FreeSimulation(Simulation *sim) {
+  GameState *state = &sim->state;
+  FreeSnapshotBuffer(&sim->snapshots);
+  FreeFieldMap(&state->fields);
+  FreeIrrigation(&state->irrigation);
+  FreeTimerWheel(&state->timers);
+  FreePathfinder(&state->pathfinder);
+  FreeFlowFieldCache(&state->flow_fields);
+  FreeWalkGrid(&state->walk_grid);
+  FreeSpatialHash(&state->spatial);
+  FreeEntityWorld(&state->entities);
+  FreeSpscQueue(&sim->input_events);
+}
+
+static void MarkTileChanged(GameState *state, int x, int y) {
+  state->tile_version[y / WALK_CHUNK_SIZE][x / WALK_CHUNK_SIZE]++;
+}
+
+void SetTileObject(GameState *state, int x, int y, ObjectType object) {
+  if (x < 0 || y < 0 || x >= MAX_TILE_X || y >= MAX_TILE_Y) return;
+
+  Tile *tile = &state->tile_map[y][x];
+  tile->object = object;
+  SetCellSolid(&state->walk_grid, x, y, IsTileSolid(*tile));
+  UpdateFieldTile(&state->fields, x, y, *tile);
+  MarkTileChanged(state, x, y);
+}
+
+bool BuildFarmScene(GameState *state, unsigned int seed) {
+  // The farm sits in a clearing in the top left, the rest is generated
+  bool generated = GenerateWorld(&state->tile_map[0][0], (WorldGenDesc) {
+    .seed = seed,
+    .width = MAX_TILE_X,
+    .height = MAX_TILE_Y,
+    .clearing_width = 30,
+    .clearing_height = 15,
+    .clearing_margin = 8,
+  });
+  if (!generated) return false;
+  RebuildWalkGrid(&state->walk_grid, state->tile_map);
+
+  // A small pen so there is something to bump into
+  for (int x = 12; x <= 18; x++) {
+    SetTileObject(state, x, 2, OBJECT_FENCE);
+    SetTileObject(state, x, 7, OBJECT_FENCE);
+  }
+  for (int y = 3; y <= 6; y++) {
+    SetTileObject(state, 12, y, OBJECT_FENCE);
+    if (y != 5) SetTileObject(state, 18, y, OBJECT_FENCE);
+  }
+  SetTileObject(state, 13, 3, OBJECT_CHEST);
+
+  // And a freshly sown field next to it
+  for (int y = 3; y <= 6; y++) {
+    for (int x = 21; x <= 26; x++) {
+      Tile *tile = &state->tile_map[y][x];
+      if (TillTile(tile)) PlantCrop(tile, y < 5 ? CROP_WHEAT : CROP_TOMATO, state->tick);
+    }
+  }
+  ResetIrrigation(&state->irrigation, state->tile_map);
+  RebuildFieldMap(&state->fields, state->tile_map);
+
+  EntityWorld *entities = &state->entities;
+
+  state->player = SpawnEntity(entities, (EntityDesc) {
+    .position = (Vector2) { 0.0f, 0.0f },
+    .width = 48.f,
+    .height = 48.f,
+    .base_accel = 200,
+    .run_accel_modifier = 2,
+    .texture = PLAYER,
+    .ai = AI_NONE,
+  });
+
+  for (int i = 0; i < 6; i++) {
+    SpawnEntity(entities, (EntityDesc) {
+      .position = (Vector2) { (4 + i * 3) * TILE_SIZE, 4 * TILE_SIZE },
+      .width = 32.f,
+      .height = 32.f,
+      .base_accel = 60,
+      .run_accel_modifier = 1,
+      .texture = CHICKEN,
+      .ai = AI_WANDER,
+    });
+  }
+  for (int i = 0; i < 3; i++) {
+    SpawnEntity(entities, (EntityDesc) {
+      .position = (Vector2) { (6 + i * 6) * TILE_SIZE, 10 * TILE_SIZE },
+      .width = 64.f,
+      .height = 64.f,
+      .base_accel = 40,
+      .run_accel_modifier = 1,
+      .texture = COW,
+      .ai = AI_WANDER,
+    });
+  }
+  return true;
+}
+
+// Held input fits in one word so it can be swapped without a lock:
+// two bits per direction axis, then the run and debug flags.
+static unsigned int PackSimInput(SimInput input) {
+  return (unsigned int)(input.direction.x + 1) |
+    (unsigned int)(input.direction.y + 1) << 2 |
+    (unsigned int)input.run << 4 |
+    (unsigned int)input.debug << 5;
+}
+
+static SimInput UnpackSimInput(unsigned int bits) {
+  return (SimInput) {
+    .direction = { (float)(bits & 3) - 1, (float)(bits >> 2 & 3) - 1 },
+    .run = bits >> 4 & 1,
+    .debug = bits >> 5 & 1,
+  };
+}
+
+static void HandleInputEvent(GameState *state, InputEvent event) {
+  EntityWorld *entities = &state->entities;
+  int tile_x = floorf(event.world_pos.x / TILE_SIZE);
+  int tile_y = floorf(event.world_pos.y / TILE_SIZE);
+  bool on_map = tile_x >= 0 && tile_y >= 0 && tile_x < MAX_TILE_X && tile_y < MAX_TILE_Y;
+  Tile *tile = on_map ? &state->tile_map[tile_y][tile_x] : NULL;
+
+  switch (event.type) {
+  case INPUT_TOGGLE_FENCE: {
+    if (!tile) break;
+    SetTileObject(state, tile_x, tile_y, tile->object == OBJECT_NONE ? OBJECT_FENCE : OBJECT_NONE);
+    break;
+  }
+  case INPUT_WALK_TO: {
+    // Found by the pathfinding slice; until then the player stands still
+    state->player_route.count = 0;
+    state->route_goal = (PathPoint) { tile_x, tile_y };
+    state->route_requested = true;
+    break;
+  }
+  case INPUT_TOGGLE_FOLLOW: {
+    for (int i = 0; i < entities->count; i++) {
+      if (entities->sprite.texture[i] != CHICKEN) continue;
+      entities->ai.kind[i] = entities->ai.kind[i] == AI_FOLLOW ? AI_WANDER : AI_FOLLOW;
+    }
+    break;
+  }
+  case INPUT_USE_HOE:
+  case INPUT_USE_AXE:
+  case INPUT_USE_WATER: {
+    int p = GetEntityIndex(entities, state->player);
+    if (p < 0) break;
+    ToolAction action = TOOL_HOE + (event.type - INPUT_USE_HOE);
+    PlayEntityClip(entities, state->player, GetToolClip(action, entities->sprite.facing[p]));
+
+    if (!tile) break;
+    if (action == TOOL_HOE && TillTile(tile)) {
+      MarkTileChanged(state, tile_x, tile_y);
+      WakeIrrigation(&state->irrigation, tile_x, tile_y);
+      UpdateFieldTile(&state->fields, tile_x, tile_y, *tile);
+    }
+    if (action == TOOL_WATER && WaterCrop(tile, state->tick)) {
+      MarkTileChanged(state, tile_x, tile_y);
+      ScheduleTimer(&state->timers, state->tick + WATERED_TICKS,
+          (TimerEvent) { TIMER_CROP_DRY, tile_x, tile_y, tile->crop_planted });
+    }
+    break;
+  }
+  case INPUT_PLANT_WHEAT:
+  case INPUT_PLANT_TOMATO: {
+    CropType crop = event.type == INPUT_PLANT_WHEAT ? CROP_WHEAT : CROP_TOMATO;
+    if (!tile || !PlantCrop(tile, crop, state->tick)) break;
+    if (tile->moisture >= IRRIGATED_MOISTURE) WaterCrop(tile, state->tick);
+    MarkTileChanged(state, tile_x, tile_y);
+    break;
+  }
+  case INPUT_HARVEST: {
+    CropType crop = tile ? HarvestCrop(tile, state->tick) : CROP_NONE;
+    if (crop == CROP_NONE) break;
+    state->harvested[crop]++;
+    MarkTileChanged(state, tile_x, tile_y);
+    break;
+  }
+  }
+}
+
+static void SteerPlayer(GameState *state, SimInput input) {
+  EntityWorld *entities = &state->entities;
+  int p = GetEntityIndex(entities, state->player);
+  if (p < 0) return;
+
+  TransformComponents *tr = &entities->transform;
+  VelocityComponents *vel = &entities->velocity;
+
+  vel->current_accel[p] = vel->base_accel[p];
+  if (input.run)
+    vel->current_accel[p] *= vel->run_accel_modifier[p];
+
+  vel->dir_x[p] = input.direction.x;
+  vel->dir_y[p] = input.direction.y;
+
+  // Walking along a route until any key takes over again
+  Route *route = &state->player_route;
+  if (vel->dir_x[p] != 0.f || vel->dir_y[p] != 0.f) {
+    route->count = 0;
+  }
+  if (route->next < route->count) {
+    PathPoint waypoint = route->points[route->next];
+    if (tr->cell_x[p] == waypoint.x && tr->cell_y[p] == waypoint.y) {
+      route->next++;
+    }
+    if (route->next < route->count) {
+      waypoint = route->points[route->next];
+      vel->dir_x[p] = (waypoint.x > tr->cell_x[p]) - (waypoint.x < tr->cell_x[p]);
+      vel->dir_y[p] = (waypoint.y > tr->cell_y[p]) - (waypoint.y < tr->cell_y[p]);
+    }
+  }
+}
+
+static void FireWorldTimer(void *ctx, TimerEvent event) {
+  GameState *state = ctx;
+  switch (event.kind) {
+  case TIMER_CROP_DRY: {
+    // Harvested or replanted since, the stamp won't match any more. Irrigated
+    // soil keeps it watered.
+    Tile *tile = &state->tile_map[event.y][event.x];
+    if (tile->crop_planted != event.stamp || tile->moisture >= IRRIGATED_MOISTURE) break;
+    if (DryCrop(tile, state->tick)) {
+      MarkTileChanged(state, event.x, event.y);
+    }
+    break;
+  }
+  }
+}
+
+// Moves the wetting front on, and waters or dries the crops it passes over
+static void UpdateIrrigation(GameState *state) {
+  Irrigation *irrigation = &state->irrigation;
+  StepIrrigation(irrigation, state->tile_map);
+
+  for (int i = 0; i < irrigation->changed_count; i++) {
+    int x, y;
+    GetIrrigationCell(irrigation, irrigation->changed[i], &x, &y);
+    Tile *tile = &state->tile_map[y][x];
+    bool was_wet = tile->moisture >= IRRIGATED_MOISTURE;
+    tile->moisture = GetMoisture(irrigation, irrigation->changed[i]);
+    bool wet = tile->moisture >= IRRIGATED_MOISTURE;
+    if (wet && !was_wet) WaterCrop(tile, state->tick);
+    if (was_wet && !wet) DryCrop(tile, state->tick);
+    MarkTileChanged(state, x, y);
+  }
+}
+
+static const FlowField *StepSimulation(GameState *state, SimInput input,
+    const InputEvent *events, int event_count, float dt) {
+  EntityWorld *entities = &state->entities;
+
+  AdvanceTimerWheel(&state->timers, state->tick, FireWorldTimer, state);
+  if (state->tick % IRRIGATION_STEP_TICKS == 0) UpdateIrrigation(state);
+
+  for (int i = 0; i < event_count; i++) {
+    HandleInputEvent(state, events[i]);
+  }
+  QueueDueWanderers(state, dt);
+  RunSlicedSystems(&state->scheduler);
+  SteerPlayer(state, input);
+
+  const FlowField *to_player = NULL;
+  int p = GetEntityIndex(entities, state->player);
+  if (p >= 0) {
+    to_player = GetFlowField(&state->flow_fields, &state->walk_grid,
+        entities->transform.cell_x[p], entities->transform.cell_y[p]);
+    FollowFlowField(entities, &state->flow_fields, to_player, AI_FOLLOW);
+  }
+
+  UpdateEntityMovement(entities, dt);
+  ResolveEntityCollisions(entities, &state->walk_grid);
+  UpdateEntityAnimation(entities, dt);
+  RebuildSpatialHash(&state->spatial, entities);
+
+  state->tick++;
+  return to_player;
+}
+
+static void WriteRenderSnapshot(GameState *state, RenderSnapshot *snapshot,
+    const FlowField *to_player, bool debug) {
+  snapshot->tick = state->tick;
+
+  for (int cy = 0; cy < SNAPSHOT_CHUNKS_Y; cy++) {
+    for (int cx = 0; cx < SNAPSHOT_CHUNKS_X; cx++) {
+      if (snapshot->chunk_version[cy][cx] == state->tile_version[cy][cx]) continue;
+      snapshot->chunk_version[cy][cx] = state->tile_version[cy][cx];
+
+      int x0 = cx * WALK_CHUNK_SIZE;
+      int x1 = x0 + WALK_CHUNK_SIZE < MAX_TILE_X ? x0 + WALK_CHUNK_SIZE : MAX_TILE_X;
+      int y1 = (cy + 1) * WALK_CHUNK_SIZE < MAX_TILE_Y ? (cy + 1) * WALK_CHUNK_SIZE : MAX_TILE_Y;
+      for (int y = cy * WALK_CHUNK_SIZE; y < y1; y++) {
+        memcpy(&snapshot->tile_map[y][x0], &state->tile_map[y][x0], (x1 - x0) * sizeof(Tile));
+      }
+    }
+  }
+
+  const EntityWorld *entities = &state->entities;
+  const TransformComponents *tr = &entities->transform;
+  for (int i = 0; i < entities->count; i++) {
+    // Clips may draw from another sheet than the entity's own (tool swings)
+    AnimClipId clip = entities->sprite.clip[i];
+    snapshot->entities[i] = (RenderEntity) {
+      .x = tr->pos_x[i],
+      .y = tr->pos_y[i],
+      .prev_x = tr->prev_x[i],
+      .prev_y = tr->prev_y[i],
+      .width = tr->width[i],
+      .height = tr->height[i],
+      .texture = clip != CLIP_NONE ? AnimClips[clip].texture : entities->sprite.texture[i],
+      .frame = entities->sprite.frame_rect[i],
+    };
+  }
+  snapshot->entity_count = entities->count;
+
+  int p = GetEntityIndex(entities, state->player);
+  snapshot->player = p;
+  snapshot->nearby_count = 0;
+  snapshot->route_count = 0;
+  snapshot->route_next = 0;
+  snapshot->has_flow = false;
+  snapshot->slice_count = 0;
+  if (p < 0 || !debug) return;
+
+  for (int i = 0; i < state->scheduler.count; i++) {
+    snapshot->slices[i] = state->scheduler.systems[i].stats;
+  }
+  snapshot->slice_count = state->scheduler.count;
+
+  snapshot->player_velocity = (Vector2) { entities->velocity.vel_x[p], entities->velocity.vel_y[p] };
+  snapshot->irrigation_front = state->irrigation.front_count;
+  snapshot->field_count = state->fields.field_count;
+  snapshot->player_field_size = GetFieldSize(&state->fields,
+      FindField(&state->fields, tr->cell_x[p], tr->cell_y[p]));
+  snapshot->player_clip = entities->sprite.clip[p];
+  snapshot->player_clip_frame = entities->sprite.clip_frame[p];
+
+  // Entities within two tiles of the player (the player included)
+  Vector2 center = { tr->pos_x[p] + tr->width[p] / 2.f, tr->pos_y[p] + tr->height[p] / 2.f };
+  snapshot->nearby_count = QuerySpatialRadius(&state->spatial, center,
+      2.f * TILE_SIZE, snapshot->nearby, SNAPSHOT_MAX_NEARBY);
+
+  const Route *route = &state->player_route;
+  for (int i = 0; i < route->count; i++) {
+    snapshot->route[i] = route->points[i];
+  }
+  snapshot->route_count = route->count;
+  snapshot->route_next = route->next;
+
+  if (to_player) {
+    for (int y = 0; y < MAX_TILE_Y; y++) {
+      for (int x = 0; x < MAX_TILE_X; x++) {
+        snapshot->flow[y][x] = SampleFlowField(&state->flow_fields, to_player, x, y);
+      }
+    }
+    snapshot->has_flow = true;
+  }
+}
+
+static double RunTick(Simulation *sim, SimInput input, const InputEvent *events, int event_count,
+    double time) {
+  double start = GetSimClock();
+  const FlowField *to_player = StepSimulation(&sim->state, input, events, event_count, SIM_DT);
+
+  RenderSnapshot *snapshot = GetSnapshotForWrite(&sim->snapshots);
+  WriteRenderSnapshot(&sim->state, snapshot, to_player, input.debug);
+  snapshot->time = time;
+  snapshot->step_ms = (GetSimClock() - start) * 1e3;
+  PublishSnapshot(&sim->snapshots);
+  return snapshot->step_ms;
+}
+
+double TickSimulation(Simulation *sim, SimInput input, const InputEvent *events, int event_count) {
+  return RunTick(sim, input, events, event_count, GetSimClock());
+}
+
+static int SimulationMain(void *arg) {
+  Simulation *sim = arg;
+  RegisterJobThread();
+
+  InputEvent events[MAX_INPUT_EVENTS];
+  double next_tick = GetSimClock();
+
+  while (atomic_load(&sim->running)) {
+    SimInput input = UnpackSimInput(atomic_load_explicit(&sim->held_input, memory_order_relaxed));
+    int event_count = 0;
+    while (event_count < MAX_INPUT_EVENTS && PopSpscQueue(&sim->input_events, &events[event_count])) {
+      event_count++;
+    }
+
+    if (sim->recorder) {
+      WriteReplayTick(sim->recorder, input, events, event_count);
+    }
+    RunTick(sim, input, events, event_count, next_tick);
+
+    next_tick += SIM_DT;
+    double now = GetSimClock();
+    if (now - next_tick > MAX_SIM_LAG) {
+      next_tick = now;
+    }
+    else if (next_tick > now) {
+      double wait = next_tick - now;
+      struct timespec duration = { (time_t)wait, (long)((wait - (time_t)wait) * 1e9) };
+      thrd_sleep(&duration, NULL);
+    }
+  }
+  return 0;
+}
+
+bool StartSimulation(Simulation *sim) {
+  // Publish the starting state so the renderer has a full frame right away
+  RenderSnapshot *snapshot = GetSnapshotForWrite(&sim->snapshots);
+  WriteRenderSnapshot(&sim->state, snapshot, NULL, false);
+  snapshot->time = GetSimClock();
+  PublishSnapshot(&sim->snapshots);
+
+  atomic_store(&sim->running, true);
+  if (thrd_create(&sim->thread, SimulationMain, sim) != thrd_success) {
+    atomic_store(&sim->running, false);
+    return false;
+  }
+  return true;
+}
+
+void StopSimulation(Simulation *sim) {
+  if (!atomic_load(&sim->running)) return;
+  atomic_store(&sim->running, false);
+  thrd_join(sim->thread, NULL);
+}
+
+void SetSimInput(Simulation *sim, SimInput input) {
+  atomic_store_explicit(&sim->held_input, PackSimInput(input), memory_order_relaxed);
+}
+
+void PushInputEvent(Simulation *sim, InputEvent event) {
+  PushSpscQueue(&sim->input_events, &event);
+}
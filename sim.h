@@ -0,0 +1,137 @@
+#ifndef SIM_H_
+#define SIM_H_
+
+#include "external/raylib-5.5/src/raylib.h"
+#include "game.h"
+#include "entity.h"
+#include "spatial.h"
+#include "walkgrid.h"
+#include "flowfield.h"
+#include "pathfind.h"
+#include "snapshot.h"
+#include "queue.h"
+#include "timers.h"
+#include "irrigation.h"
+#include "fields.h"
+#include "scheduler.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <threads.h>
+
+#define MAX_ENTITIES (4096)
+#define MAX_ROUTE_POINTS (SNAPSHOT_MAX_ROUTE)
+#define MAX_INPUT_EVENTS (64)
+#define SIM_DT (1.0f / FPS)
+#define WORLD_SEED (1337u)
+#define MAX_WORLD_TIMERS (65536)
+#define WATERED_TICKS (120 * FPS)
+#define IRRIGATION_STEP_TICKS (6)  // how often the wetting front moves a tile
+// Per tick budgets for the sliced systems, in items so the simulation stays
+// deterministic. Routes are by far the dearer item, one per tick is plenty
+// for a single player.
+#define PATHFIND_BUDGET (1)  // routes
+#define AI_BUDGET (512)      // wander decisions
+
+typedef struct Route {
+  PathPoint points[MAX_ROUTE_POINTS];
+  int count;
+  int next;
+} Route;
+
+typedef struct GameState {
+  Tile tile_map[MAX_TILE_Y][MAX_TILE_X];
+  unsigned int tile_version[SNAPSHOT_CHUNKS_Y][SNAPSHOT_CHUNKS_X];
+  EntityWorld entities;
+  SpatialHash spatial;
+  WalkGrid walk_grid;
+  FlowFieldCache flow_fields;
+  Pathfinder pathfinder;
+  Entity player;
+  Route player_route;
+  PathPoint route_goal;  // waiting for the pathfinding slice
+  bool route_requested;
+  int harvested[CROP_TYPE_COUNT];
+  TimerWheel timers;
+  Irrigation irrigation;
+  FieldMap fields;
+  Entity ai_due[MAX_ENTITIES];  // wanderers waiting for a decision, from ai_due_head on
+  int ai_due_head;
+  int ai_due_count;
+  SliceScheduler scheduler;
+  unsigned long long tick;
+} GameState;
+
+typedef enum {
+  INPUT_TOGGLE_FENCE,   // debug: add or remove a fence on the tile
+  INPUT_WALK_TO,        // route the player to the tile
+  INPUT_TOGGLE_FOLLOW,  // call the chickens over or let them roam
+  INPUT_USE_HOE,        // swing a tool the way the player is facing, at the tile
+  INPUT_USE_AXE,
+  INPUT_USE_WATER,
+  INPUT_PLANT_WHEAT,    // sow tilled soil
+  INPUT_PLANT_TOMATO,
+  INPUT_HARVEST,
+} InputEventType;
+
+// TimerEvent kinds scheduled on GameState.timers
+typedef enum {
+  TIMER_CROP_DRY,  // watering wears off the crop at (x, y) if stamp still matches
+} WorldTimerKind;
+
+typedef struct InputEvent {
+  InputEventType type;
+  Vector2 world_pos;
+} InputEvent;
+
+// Keys that are held rather than pressed, sampled once per rendered frame
+typedef struct SimInput {
+  Vector2 direction;
+  bool run;
+  bool debug;
+} SimInput;
+
+typedef struct ReplayWriter ReplayWriter;
+
+typedef struct Simulation {
+  GameState state;
+  SnapshotBuffer snapshots;
+
+  thrd_t thread;
+  atomic_bool running;
+
+  // Written by the main thread, read by the simulation thread
+  atomic_uint held_input;  // SimInput packed into bits
+  SpscQueue input_events;
+
+  // If set before StartSimulation, every tick's input is written to it
+  ReplayWriter *recorder;
+} Simulation;
+
+// Allocates the world. Fill in the tile map and spawn entities, then call
+// StartSimulation; from then on only the simulation thread touches state.
+bool InitSimulation(Simulation *sim);
+void FreeSimulation(Simulation *sim);
+
+// The farm the game starts on: generated terrain around a clearing with a
+// pen, the player and a few animals
+bool BuildFarmScene(GameState *state, unsigned int seed);
+
+bool StartSimulation(Simulation *sim);
+void StopSimulation(Simulation *sim);
+
+// Runs one tick on the calling thread, for headless runs without
+// StartSimulation. Returns how long the step took in milliseconds.
+double TickSimulation(Simulation *sim, SimInput input, const InputEvent *events, int event_count);
+
+// Main thread only. Events are dropped if the simulation is so far behind
+// that MAX_INPUT_EVENTS are already waiting.
+void SetSimInput(Simulation *sim, SimInput input);
+void PushInputEvent(Simulation *sim, InputEvent event);
+
+// Changes a tile and marks its chunk for the next snapshot
+void SetTileObject(GameState *state, int x, int y, ObjectType object);
+
+// Monotonic seconds, the clock snapshots are stamped with
+double GetSimClock(void);
+
+#endif // SIM_H_
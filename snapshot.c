@@ -0,0 +1,74 @@
+#include "snapshot.h"
+#include <stdlib.h>
+
+#define SNAPSHOT_FRESH (4u)
+#define SNAPSHOT_INDEX (3u)
+
+bool InitSnapshotBuffer(SnapshotBuffer *buffer, int entity_capacity) {
+  for (int i = 0; i < 3; i++) {
+    RenderSnapshot *snapshot = &buffer->snapshots[i];
+    *snapshot = (RenderSnapshot) {0};
+    snapshot->entities = malloc(entity_capacity * sizeof(RenderEntity));
+    snapshot->entity_capacity = entity_capacity;
+    snapshot->player = -1;
+    if (!snapshot->entities) {
+      FreeSnapshotBuffer(buffer);
+      return false;
+    }
+  }
+
+  buffer->write = 0;
+  atomic_init(&buffer->middle, 1);
+  buffer->read = 2;
+  return true;
+}
+
+void FreeSnapshotBuffer(SnapshotBuffer *buffer) {
+  for (int i = 0; i < 3; i++) {
+    free(buffer->snapshots[i].entities);
+    buffer->snapshots[i].entities = NULL;
+  }
+}
+
+RenderSnapshot *GetSnapshotForWrite(SnapshotBuffer *buffer) {
+  return &buffer->snapshots[buffer->write];
+}
+
+void PublishSnapshot(SnapshotBuffer *buffer) {
+  // Release makes the writes visible to the reader, acquire makes sure the
+  // reader is done with the buffer we get back before we overwrite it.
+  unsigned int old = atomic_exchange_explicit(&buffer->middle,
+      buffer->write | SNAPSHOT_FRESH, memory_order_acq_rel);
+  buffer->write = old & SNAPSHOT_INDEX;
+}
+
+const RenderSnapshot *AcquireSnapshot(SnapshotBuffer *buffer) {
+  if (atomic_load_explicit(&buffer->middle, memory_order_relaxed) & SNAPSHOT_FRESH) {
+    unsigned int old = atomic_exchange_explicit(&buffer->middle,
+        buffer->read, memory_order_acq_rel);
+    buffer->read = old & SNAPSHOT_INDEX;
+  }
+  return &buffer->snapshots[buffer->read];
+}
+
+Rectangle GetRenderEntityRect(const RenderEntity *entity, float alpha) {
+  return (Rectangle) {
+    entity->prev_x + (entity->x - entity->prev_x) * alpha,
+    entity->prev_y + (entity->y - entity->prev_y) * alpha,
+    entity->width,
+    entity->height,
+  };
+}
+
+void DrawSnapshotEntities(const RenderSnapshot *snapshot, Texture2D *const *textures, float alpha) {
+  for (int i = 0; i < snapshot->entity_count; i++) {
+    const RenderEntity *entity = &snapshot->entities[i];
+    DrawTexturePro(*textures[entity->texture],
+        entity->frame,
+        GetRenderEntityRect(entity, alpha),
+        (Vector2) { 0.0f, 0.0f },
+        0.0f,
+        WHITE
+    );
+  }
+}
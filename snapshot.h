@@ -0,0 +1,88 @@
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+#include "external/raylib-5.5/src/raylib.h"
+#include "game.h"
+#include "pathfind.h"
+#include "walkgrid.h"
+#include "scheduler.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+
+#define SNAPSHOT_CHUNKS_X ((MAX_TILE_X + WALK_CHUNK_SIZE - 1) / WALK_CHUNK_SIZE)
+#define SNAPSHOT_CHUNKS_Y ((MAX_TILE_Y + WALK_CHUNK_SIZE - 1) / WALK_CHUNK_SIZE)
+#define SNAPSHOT_MAX_ROUTE (256)
+#define SNAPSHOT_MAX_NEARBY (64)
+
+typedef struct RenderEntity {
+  float x;
+  float y;
+  float prev_x;  // where the entity was one tick earlier
+  float prev_y;
+  float width;
+  float height;
+  TextureType texture;
+  Rectangle frame;
+} RenderEntity;
+
+// Everything the renderer needs from one simulation tick. The simulation
+// fills one in and publishes it; after that it is never written again until
+// the renderer has let go of it.
+typedef struct RenderSnapshot {
+  unsigned long long tick;
+  double time;  // GetSimClock() time the tick was due
+
+  // Only chunks whose version moved since this buffer was last written get
+  // copied, so an idle map costs nothing per tick.
+  unsigned int chunk_version[SNAPSHOT_CHUNKS_Y][SNAPSHOT_CHUNKS_X];
+  Tile tile_map[MAX_TILE_Y][MAX_TILE_X];
+
+  RenderEntity *entities;
+  int entity_count;
+  int entity_capacity;
+  int player;  // index into entities, -1 when there is none
+
+  // Debug overlay
+  Vector2 player_velocity;
+  int irrigation_front;
+  int field_count;
+  int player_field_size;  // tilled tiles in the field the player stands in
+  int player_clip;
+  float player_clip_frame;
+  int nearby[SNAPSHOT_MAX_NEARBY];
+  int nearby_count;
+  PathPoint route[SNAPSHOT_MAX_ROUTE];
+  int route_count;
+  int route_next;
+  bool has_flow;
+  Vector2 flow[MAX_TILE_Y][MAX_TILE_X];
+  SliceStats slices[MAX_SLICED_SYSTEMS];  // backlog of the sliced systems
+  int slice_count;
+  float step_ms;
+} RenderSnapshot;
+
+// Lock-free triple buffer: the simulation always has a buffer to write, the
+// renderer always has a complete one to read, and the third holds the most
+// recent publish. Neither side ever waits for the other.
+typedef struct SnapshotBuffer {
+  RenderSnapshot snapshots[3];
+  atomic_uint middle;  // buffer index, plus SNAPSHOT_FRESH once published
+  unsigned int write;  // owned by the simulation thread
+  unsigned int read;   // owned by the render thread
+} SnapshotBuffer;
+
+bool InitSnapshotBuffer(SnapshotBuffer *buffer, int entity_capacity);
+void FreeSnapshotBuffer(SnapshotBuffer *buffer);
+
+// Writer side
+RenderSnapshot *GetSnapshotForWrite(SnapshotBuffer *buffer);
+void PublishSnapshot(SnapshotBuffer *buffer);
+
+// Reader side: the newest published snapshot, valid until the next call
+const RenderSnapshot *AcquireSnapshot(SnapshotBuffer *buffer);
+
+// Position between the last two ticks, alpha in 0..1
+Rectangle GetRenderEntityRect(const RenderEntity *entity, float alpha);
+void DrawSnapshotEntities(const RenderSnapshot *snapshot, Texture2D *const *textures, float alpha);
+
+#endif // SNAPSHOT_H_
@@ -0,0 +1,138 @@
+#include "spatial.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static inline int HashCell(int x, int y, int mask) {
+  return (int)(((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u)) & mask;
+}
+
+bool InitSpatialHash(SpatialHash *hash, int capacity) {
+  int buckets = 1;
+  while (buckets < capacity * 2) buckets <<= 1;
+
+  *hash = (SpatialHash) {
+    .capacity = capacity,
+    .bucket_mask = buckets - 1,
+    .bucket_start = calloc(buckets + 1, sizeof(int)),
+    .index = calloc(capacity, sizeof(int)),
+    .center_x = calloc(capacity, sizeof(float)),
+    .center_y = calloc(capacity, sizeof(float)),
+    .cell_x = calloc(capacity, sizeof(int)),
+    .cell_y = calloc(capacity, sizeof(int)),
+    .scratch = calloc(capacity, sizeof(int)),
+  };
+
+  if (!hash->bucket_start || !hash->index || !hash->center_x || !hash->center_y ||
+      !hash->cell_x || !hash->cell_y || !hash->scratch) {
+    FreeSpatialHash(hash);
+    return false;
+  }
+  return true;
+}
+
+void FreeSpatialHash(SpatialHash *hash) {
+  free(hash->bucket_start);
+  free(hash->index);
+  free(hash->center_x);
+  free(hash->center_y);
+  free(hash->cell_x);
+  free(hash->cell_y);
+  free(hash->scratch);
+  *hash = (SpatialHash) {0};
+}
+
+void RebuildSpatialHash(SpatialHash *hash, const EntityWorld *world) {
+  const TransformComponents *tr = &world->transform;
+  int count = world->count < hash->capacity ? world->count : hash->capacity;
+  int buckets = hash->bucket_mask + 1;
+  int *start = hash->bucket_start;
+  int *bucket_of = hash->scratch;
+
+  memset(start, 0, (buckets + 1) * sizeof(int));
+  for (int i = 0; i < count; i++) {
+    bucket_of[i] = HashCell(tr->cell_x[i], tr->cell_y[i], hash->bucket_mask);
+    start[bucket_of[i] + 1]++;
+  }
+  for (int b = 0; b < buckets; b++) {
+    start[b + 1] += start[b];
+  }
+
+  // Scatter using start[] as write cursors, then shift them back so that
+  // start[b]..start[b + 1] is bucket b again.
+  for (int i = 0; i < count; i++) {
+    int slot = start[bucket_of[i]]++;
+    hash->index[slot] = i;
+    hash->center_x[slot] = tr->pos_x[i] + tr->width[i] / 2.f;
+    hash->center_y[slot] = tr->pos_y[i] + tr->height[i] / 2.f;
+    hash->cell_x[slot] = tr->cell_x[i];
+    hash->cell_y[slot] = tr->cell_y[i];
+  }
+  memmove(start + 1, start, buckets * sizeof(int));
+  start[0] = 0;
+
+  hash->count = count;
+}
+
+typedef struct {
+  bool circle;
+  Vector2 center;
+  float radius_sq;
+  Rectangle rect;
+} QueryShape;
+
+static inline bool ShapeContains(const QueryShape *shape, float x, float y) {
+  if (shape->circle) {
+    float dx = x - shape->center.x;
+    float dy = y - shape->center.y;
+    return dx * dx + dy * dy <= shape->radius_sq;
+  }
+  return x >= shape->rect.x && y >= shape->rect.y &&
+    x <= shape->rect.x + shape->rect.width && y <= shape->rect.y + shape->rect.height;
+}
+
+static int QueryCells(const SpatialHash *hash, const QueryShape *shape,
+    int x0, int y0, int x1, int y1, int *out, int max_out) {
+  int found = 0;
+
+  // A range covering more cells than there are buckets is cheaper to scan
+  long long cells = (long long)(x1 - x0 + 1) * (y1 - y0 + 1);
+  if (cells > hash->bucket_mask + 1) {
+    for (int slot = 0; slot < hash->count && found < max_out; slot++) {
+      if (ShapeContains(shape, hash->center_x[slot], hash->center_y[slot])) {
+        out[found++] = hash->index[slot];
+      }
+    }
+    return found;
+  }
+
+  for (int cy = y0; cy <= y1; cy++) {
+    for (int cx = x0; cx <= x1; cx++) {
+      int b = HashCell(cx, cy, hash->bucket_mask);
+      for (int slot = hash->bucket_start[b]; slot < hash->bucket_start[b + 1]; slot++) {
+        // different cells can share a bucket
+        if (hash->cell_x[slot] != cx || hash->cell_y[slot] != cy) continue;
+        if (!ShapeContains(shape, hash->center_x[slot], hash->center_y[slot])) continue;
+        if (found == max_out) return found;
+        out[found++] = hash->index[slot];
+      }
+    }
+  }
+  return found;
+}
+
+int QuerySpatialRadius(const SpatialHash *hash, Vector2 center, float radius, int *out, int max_out) {
+  QueryShape shape = { .circle = true, .center = center, .radius_sq = radius * radius };
+  return QueryCells(hash, &shape,
+      floorf((center.x - radius) / TILE_SIZE), floorf((center.y - radius) / TILE_SIZE),
+      floorf((center.x + radius) / TILE_SIZE), floorf((center.y + radius) / TILE_SIZE),
+      out, max_out);
+}
+
+int QuerySpatialRect(const SpatialHash *hash, Rectangle rect, int *out, int max_out) {
+  QueryShape shape = { .circle = false, .rect = rect };
+  return QueryCells(hash, &shape,
+      floorf(rect.x / TILE_SIZE), floorf(rect.y / TILE_SIZE),
+      floorf((rect.x + rect.width) / TILE_SIZE), floorf((rect.y + rect.height) / TILE_SIZE),
+      out, max_out);
+}
@@ -0,0 +1,39 @@
+#ifndef SPATIAL_H_
+#define SPATIAL_H_
+
+#include "external/raylib-5.5/src/raylib.h"
+#include "entity.h"
+#include <stdbool.h>
+
+// Uniform grid over TILE_SIZE cells, hashed into a fixed bucket table.
+// Rebuilt every tick with a counting sort, so entries of one bucket are
+// contiguous and a query only reads the buckets its cells map to.
+typedef struct SpatialHash {
+  int capacity;
+  int count;
+  int bucket_mask;
+  int *bucket_start;  // bucket_mask + 2 prefix sums
+
+  // Entries sorted by bucket. Centers and cells are copied out of the
+  // entity world so queries don't chase into the component arrays.
+  int *index;
+  float *center_x;
+  float *center_y;
+  int *cell_x;
+  int *cell_y;
+
+  int *scratch;
+} SpatialHash;
+
+bool InitSpatialHash(SpatialHash *hash, int capacity);
+void FreeSpatialHash(SpatialHash *hash);
+
+// Uses the cells computed by the movement system, call it after moving.
+void RebuildSpatialHash(SpatialHash *hash, const EntityWorld *world);
+
+// Both queries write dense entity indices (valid until the next spawn or
+// despawn) into out and return how many were found, at most max_out.
+int QuerySpatialRadius(const SpatialHash *hash, Vector2 center, float radius, int *out, int max_out);
+int QuerySpatialRect(const SpatialHash *hash, Rectangle rect, int *out, int max_out);
+
+#endif // SPATIAL_H_
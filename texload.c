@@ -0,0 +1,138 @@
+#include "texload.h"
+
+static void DecodeImage(void *data) {
+  TextureLoad *load = data;
+  load->image = LoadImage(load->path);
+
+  // Sized to hold every load, so this can't fail
+  int index = (int)(load - load->loader->loads);
+  PushMpscQueue(&load->loader->decoded, &index);
+}
+
+bool InitTextureLoader(TextureLoader *loader, const AssetPack *pack) {
+  *loader = (TextureLoader) { .pack = pack };
+  if (!InitMpscQueue(&loader->decoded, MAX_TEXTURE_LOADS, sizeof(int))) return false;
+  if (!InitMpscQueue(&loader->reloaded, MAX_TEXTURE_LOADS, sizeof(TextureReload))) {
+    FreeMpscQueue(&loader->decoded);
+    return false;
+  }
+
+  Image checked = GenImageChecked(16, 16, 8, 8, (Color) { 96, 96, 96, 255 }, (Color) { 128, 128, 128, 255 });
+  loader->placeholder = LoadTextureFromImage(checked);
+  UnloadImage(checked);
+  return true;
+}
+
+void FreeTextureLoader(TextureLoader *loader) {
+  WaitForCounter(&loader->counter);
+
+  int index;
+  while (PopMpscQueue(&loader->decoded, &index)) {
+    if (!loader->loads[index].mapped) UnloadImage(loader->loads[index].image);
+  }
+  TextureReload reload;
+  while (PopMpscQueue(&loader->reloaded, &reload)) {
+    UnloadImage(reload.image);
+  }
+  for (int i = 0; i < loader->load_count; i++) {
+    TextureLoad *load = &loader->loads[i];
+    if (load->resident) UnloadTexture(*load->texture);
+    *load->texture = (Texture2D) {0};
+  }
+  UnloadTexture(loader->placeholder);
+  FreeMpscQueue(&loader->decoded);
+  FreeMpscQueue(&loader->reloaded);
+}
+
+bool LoadTextureAsync(TextureLoader *loader, Texture2D *texture, const char *path) {
+  if (loader->load_count >= MAX_TEXTURE_LOADS) {
+    TraceLog(LOG_WARNING, "Too many texture loads, not loading %s", path);
+    *texture = loader->placeholder;
+    return false;
+  }
+
+  TextureLoad *load = &loader->loads[loader->load_count++];
+  *load = (TextureLoad) {
+    .loader = loader,
+    .path = path,
+    .texture = texture,
+  };
+  *texture = loader->placeholder;
+
+  const PackEntry *entry = loader->pack ? FindPackEntry(loader->pack, path) : NULL;
+  if (entry) {
+    // Already decoded, the upload reads straight out of the mapping
+    load->image = (Image) {
+      .data = (void *)GetPackEntryData(loader->pack, entry),
+      .width = entry->width,
+      .height = entry->height,
+      .mipmaps = entry->mipmaps,
+      .format = entry->format,
+    };
+    load->mapped = true;
+    int index = loader->load_count - 1;
+    PushMpscQueue(&loader->decoded, &index);
+    return true;
+  }
+
+  RunJobs(&(Job) { DecodeImage, load }, 1, &loader->counter);
+  return true;
+}
+
+bool QueueTextureReload(TextureLoader *loader, int index, Image image) {
+  return PushMpscQueue(&loader->reloaded, &(TextureReload) { index, image });
+}
+
+// Swaps the new texture in for whatever load currently shows
+static bool SwapTexture(TextureLoader *loader, TextureLoad *load, Image image) {
+  Texture2D texture = LoadTextureFromImage(image);
+  if (!IsTextureValid(texture)) return false;
+
+  if (load->resident) UnloadTexture(*load->texture);
+  else loader->resident_count++;
+  *load->texture = texture;
+  load->resident = true;
+  load->version++;
+  return true;
+}
+
+int FindTextureLoad(const TextureLoader *loader, const Texture2D *texture) {
+  for (int i = 0; i < loader->load_count; i++) {
+    if (loader->loads[i].texture == texture) return i;
+  }
+  return -1;
+}
+
+int UploadDecodedTextures(TextureLoader *loader, double budget) {
+  double start = GetTime();
+  int uploaded = 0;
+
+  int index;
+  while (PopMpscQueue(&loader->decoded, &index)) {
+    TextureLoad *load = &loader->loads[index];
+    if (load->image.data == NULL) {
+      TraceLog(LOG_WARNING, "Could not decode %s, keeping the placeholder", load->path);
+    }
+    else {
+      // A hot reload may have overtaken the first decode, don't go back to it
+      if (!load->resident) uploaded += SwapTexture(loader, load, load->image);
+      if (!load->mapped) UnloadImage(load->image);
+      load->image = (Image) {0};
+    }
+
+    if (GetTime() - start >= budget) return uploaded;
+  }
+
+  TextureReload reload;
+  while (PopMpscQueue(&loader->reloaded, &reload)) {
+    TextureLoad *load = &loader->loads[reload.index];
+    if (SwapTexture(loader, load, reload.image)) {
+      TraceLog(LOG_INFO, "Reloaded %s", load->path);
+      uploaded++;
+    }
+    UnloadImage(reload.image);
+
+    if (GetTime() - start >= budget) break;
+  }
+  return uploaded;
+}
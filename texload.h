@@ -0,0 +1,66 @@
+#ifndef TEXLOAD_H_
+#define TEXLOAD_H_
+
+#include "external/raylib-5.5/src/raylib.h"
+#include "assetpack.h"
+#include "jobs.h"
+#include "queue.h"
+#include <stdbool.h>
+
+#define MAX_TEXTURE_LOADS (64)
+#define TEXTURE_UPLOAD_BUDGET (0.002)  // seconds of uploads per frame
+
+typedef struct TextureLoader TextureLoader;
+
+typedef struct TextureLoad {
+  TextureLoader *loader;
+  const char *path;
+  Texture2D *texture;  // holds the placeholder until the upload is done
+  Image image;         // written by the decoding job
+  bool mapped;         // image points into the asset pack, not ours to free
+  bool resident;
+  unsigned int version;  // bumped every time a new texture is swapped in
+} TextureLoad;
+
+// A fresh decode of an already loaded file
+typedef struct TextureReload {
+  int index;
+  Image image;
+} TextureReload;
+
+// Images are decoded on the job threads and handed back through a queue;
+// only the GL thread creates textures from them. Images found in the asset
+// pack skip decoding and go straight to the queue.
+struct TextureLoader {
+  const AssetPack *pack;
+  Texture2D placeholder;
+  TextureLoad loads[MAX_TEXTURE_LOADS];
+  int load_count;
+  int resident_count;
+  MpscQueue decoded;   // indices into loads
+  MpscQueue reloaded;  // TextureReloads, owned by the queue until uploaded
+  JobCounter counter;
+};
+
+// GL thread only, after InitWindow and InitJobSystem. pack may be NULL,
+// otherwise it has to stay open until FreeTextureLoader.
+bool InitTextureLoader(TextureLoader *loader, const AssetPack *pack);
+void FreeTextureLoader(TextureLoader *loader);
+
+// Points texture at the placeholder and starts decoding path in the
+// background. path must stay valid until the load is done.
+bool LoadTextureAsync(TextureLoader *loader, Texture2D *texture, const char *path);
+
+// Any thread. Takes ownership of image; it replaces the texture of load
+// index on a later UploadDecodedTextures. Fails if too many are waiting.
+bool QueueTextureReload(TextureLoader *loader, int index, Image image);
+
+// Index into loads of the load that fills texture, -1 if there is none.
+// Caches drawn from textures can keep the versions of the loads they used.
+int FindTextureLoad(const TextureLoader *loader, const Texture2D *texture);
+
+// Creates textures for decoded and reloaded images until budget seconds
+// have passed, always at least one. Returns how many were swapped in.
+int UploadDecodedTextures(TextureLoader *loader, double budget);
+
+#endif // TEXLOAD_H_
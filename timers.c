@@ -0,0 +1,163 @@
+#include "timers.h"
+#include <stdlib.h>
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+#define WHEEL_RANGE (UINT64_C(1) << (TIMER_WHEEL_LEVELS * TIMER_WHEEL_BITS))
+
+bool InitTimerWheel(TimerWheel *wheel, int capacity, uint64_t now) {
+  *wheel = (TimerWheel) { .capacity = capacity, .now = now };
+  wheel->timers = malloc((size_t)capacity * sizeof(*wheel->timers));
+  if (!wheel->timers) return false;
+
+  for (int i = 0; i < capacity; i++) {
+    wheel->timers[i] = (Timer) { .slot = -1, .index = i + 1 < capacity ? i + 1 : -1, .generation = 1 };
+  }
+  wheel->free_head = capacity > 0 ? 0 : -1;
+  return true;
+}
+
+void FreeTimerWheel(TimerWheel *wheel) {
+  for (int i = 0; i < TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS; i++) {
+    free(wheel->slots[i].timers);
+  }
+  free(wheel->timers);
+  *wheel = (TimerWheel) {0};
+}
+
+// The coarsest slot that can't come round again before the timer is due
+static int GetTimerSlot(const TimerWheel *wheel, uint64_t expires) {
+  uint64_t delta = expires - wheel->now;
+  // Further out than the wheel reaches: park it in the last slot that comes
+  // round, it gets filed again from there
+  uint64_t key = delta < WHEEL_RANGE ? expires : wheel->now + WHEEL_RANGE - 1;
+
+  int level = 0;
+  while (level < TIMER_WHEEL_LEVELS - 1 && delta >= UINT64_C(1) << ((level + 1) * TIMER_WHEEL_BITS)) {
+    level++;
+  }
+  return level * TIMER_WHEEL_SLOTS + (int)(key >> (level * TIMER_WHEEL_BITS) & SLOT_MASK);
+}
+
+static bool LinkTimer(TimerWheel *wheel, int i, int slot_index) {
+  TimerSlot *slot = &wheel->slots[slot_index];
+  if (slot->count == slot->capacity) {
+    int capacity = slot->capacity ? slot->capacity * 2 : 16;
+    int *timers = realloc(slot->timers, capacity * sizeof(*timers));
+    if (!timers) return false;
+    slot->timers = timers;
+    slot->capacity = capacity;
+  }
+
+  if (slot_index < TIMER_WHEEL_SLOTS) {
+    wheel->pending[slot_index / 64] |= UINT64_C(1) << (slot_index % 64);
+  }
+  wheel->timers[i].slot = slot_index;
+  wheel->timers[i].index = slot->count;
+  slot->timers[slot->count++] = i;
+  return true;
+}
+
+// Swaps the last timer in the slot into the hole
+static void UnlinkTimer(TimerWheel *wheel, int i) {
+  Timer *timer = &wheel->timers[i];
+  TimerSlot *slot = &wheel->slots[timer->slot];
+  int last = slot->timers[--slot->count];
+  slot->timers[timer->index] = last;
+  wheel->timers[last].index = timer->index;
+
+  if (slot->count == 0 && timer->slot < TIMER_WHEEL_SLOTS) {
+    wheel->pending[timer->slot / 64] &= ~(UINT64_C(1) << (timer->slot % 64));
+  }
+}
+
+static void ReleaseTimer(TimerWheel *wheel, int i) {
+  Timer *timer = &wheel->timers[i];
+  timer->slot = -1;
+  timer->generation = timer->generation + 1 ? timer->generation + 1 : 1;
+  timer->index = wheel->free_head;
+  wheel->free_head = i;
+  wheel->count--;
+}
+
+TimerId ScheduleTimer(TimerWheel *wheel, uint64_t tick, TimerEvent event) {
+  int i = wheel->free_head;
+  if (i < 0) return TIMER_NONE;
+
+  Timer *timer = &wheel->timers[i];
+  timer->expires = tick > wheel->now ? tick : wheel->now + 1;
+  timer->event = event;
+  int next_free = timer->index;
+  if (!LinkTimer(wheel, i, GetTimerSlot(wheel, timer->expires))) return TIMER_NONE;
+
+  wheel->free_head = next_free;
+  wheel->count++;
+  return (TimerId)timer->generation << 32 | (uint32_t)i;
+}
+
+bool CancelTimer(TimerWheel *wheel, TimerId id) {
+  uint32_t i = (uint32_t)id;
+  if (i >= (uint32_t)wheel->capacity) return false;
+
+  Timer *timer = &wheel->timers[i];
+  if (timer->generation != (uint32_t)(id >> 32) || timer->slot < 0) return false;
+  UnlinkTimer(wheel, i);
+  ReleaseTimer(wheel, i);
+  return true;
+}
+
+// Refiles every timer in a slot relative to the current tick, which moves
+// them at least one level down. Should a slot fail to grow, the timer stays
+// put and is refiled the next time this slot comes round.
+static void CascadeSlot(TimerWheel *wheel, int level) {
+  int slot_index = level * TIMER_WHEEL_SLOTS + (int)(wheel->now >> (level * TIMER_WHEEL_BITS) & SLOT_MASK);
+  TimerSlot *slot = &wheel->slots[slot_index];
+
+  int kept = 0;
+  for (int k = 0; k < slot->count; k++) {
+    int i = slot->timers[k];
+    if (!LinkTimer(wheel, i, GetTimerSlot(wheel, wheel->timers[i].expires))) {
+      wheel->timers[i].index = kept;
+      slot->timers[kept++] = i;
+    }
+  }
+  slot->count = kept;
+}
+
+// The next tick after now with something to do: a non-empty first level
+// slot, or else the next time the first level wraps and refills
+static uint64_t NextBusyTick(const TimerWheel *wheel) {
+  int from = (int)(wheel->now & SLOT_MASK) + 1;
+  for (int word = from / 64; word < TIMER_WHEEL_SLOTS / 64; word++) {
+    uint64_t bits = wheel->pending[word];
+    if (word == from / 64) bits &= ~UINT64_C(0) << (from % 64);
+    if (bits) return (wheel->now & ~(uint64_t)SLOT_MASK) + word * 64 + __builtin_ctzll(bits);
+  }
+  return (wheel->now | SLOT_MASK) + 1;
+}
+
+void AdvanceTimerWheel(TimerWheel *wheel, uint64_t tick, TimerFn fire, void *ctx) {
+  while (wheel->now < tick) {
+    uint64_t now = wheel->count > 0 ? NextBusyTick(wheel) : tick;
+    if (now > tick) {
+      wheel->now = tick;
+      return;
+    }
+    wheel->now = now;
+
+    for (int level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+      if ((now & ((UINT64_C(1) << (level * TIMER_WHEEL_BITS)) - 1)) == 0) {
+        CascadeSlot(wheel, level);
+      }
+    }
+
+    // One at a time off the end, so fire can cancel what is still queued
+    TimerSlot *slot = &wheel->slots[now & SLOT_MASK];
+    while (slot->count > 0) {
+      int i = slot->timers[slot->count - 1];
+      TimerEvent event = wheel->timers[i].event;
+      UnlinkTimer(wheel, i);
+      ReleaseTimer(wheel, i);
+      fire(ctx, event);
+    }
+  }
+}
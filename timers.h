@@ -0,0 +1,73 @@
+#ifndef TIMERS_H_
+#define TIMERS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Hierarchical timing wheel for "do X at tick T" world events. Four levels
+// of 256 slots cover 2^32 ticks; a timer sits in the level its distance
+// falls in and drops one level down each time the level below wraps, so
+// insert and cancel are O(1) and a timer is touched at most three more
+// times before it fires.
+//
+// Slots are arrays of timer indices rather than linked lists: moving a slot
+// down a level walks a flat array, so the loads of the timers in it can all
+// be in flight at once instead of chasing one pointer after another.
+#define TIMER_WHEEL_LEVELS (4)
+#define TIMER_WHEEL_BITS (8)
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+
+// Slot index in the low 32 bits, the slot's reuse count above, so a stale
+// id never cancels somebody else's timer
+typedef uint64_t TimerId;
+#define TIMER_NONE ((TimerId)0)
+
+// What to do when a timer fires; kind and payload mean whatever the owner
+// of the wheel wants them to
+typedef struct TimerEvent {
+  int kind;
+  int x;
+  int y;
+  unsigned int stamp;
+} TimerEvent;
+
+typedef struct Timer {
+  uint64_t expires;
+  TimerEvent event;
+  int slot;    // level * TIMER_WHEEL_SLOTS + slot, -1 when not armed
+  int index;   // position in the slot, or the next free timer
+  uint32_t generation;
+} Timer;
+
+typedef struct TimerSlot {
+  int *timers;
+  int count;
+  int capacity;
+} TimerSlot;
+
+typedef struct TimerWheel {
+  Timer *timers;
+  int capacity;
+  int free_head;
+  int count;
+  uint64_t now;  // last tick that has been fired
+  TimerSlot slots[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS];
+  // Bit per non-empty first level slot, so empty stretches are skipped
+  uint64_t pending[TIMER_WHEEL_SLOTS / 64];
+} TimerWheel;
+
+typedef void (*TimerFn)(void *ctx, TimerEvent event);
+
+bool InitTimerWheel(TimerWheel *wheel, int capacity, uint64_t now);
+void FreeTimerWheel(TimerWheel *wheel);
+
+// Fires on the first AdvanceTimerWheel past tick, the next tick if it is
+// already due. TIMER_NONE when the wheel is full or out of memory.
+TimerId ScheduleTimer(TimerWheel *wheel, uint64_t tick, TimerEvent event);
+// False if the timer already fired or was cancelled
+bool CancelTimer(TimerWheel *wheel, TimerId id);
+// Fires everything due up to and including tick, in tick order. fire may
+// schedule and cancel timers.
+void AdvanceTimerWheel(TimerWheel *wheel, uint64_t tick, TimerFn fire, void *ctx);
+
+#endif // TIMERS_H_
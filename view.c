@@ -0,0 +1,111 @@
+#include "view.h"
+#include <math.h>
+
+void UnloadWorldView(WorldView *view) {
+  if (view->target.id != 0) UnloadRenderTexture(view->target);
+  view->target = (RenderTexture2D) {0};
+}
+
+static bool PrepareWorldTarget(WorldView *view, int width, int height, int filter) {
+  if (view->target.id == 0 || view->target.texture.width != width || view->target.texture.height != height) {
+    UnloadWorldView(view);
+    view->target = LoadRenderTexture(width, height);
+    if (view->target.id == 0) {
+      TraceLog(LOG_WARNING, "Could not create a %dx%d world target, drawing to the screen", width, height);
+      return false;
+    }
+    view->filter = -1;
+  }
+  if (view->filter != filter) {
+    SetTextureFilter(view->target.texture, filter);
+    view->filter = filter;
+  }
+  return true;
+}
+
+static Camera2D UpdatePixelPerfectView(WorldView *view, Camera2D camera, int screen_width, int screen_height) {
+  float texel = (float)TILE_SIZE / ART_TILE_SIZE;  // world units per texel
+  // Zoomed out past a pixel per texel there is nothing to snap to
+  if (camera.zoom * texel < 1.f) return camera;
+  int scale = (int)roundf(camera.zoom * texel);
+
+  // Rounded up so the target covers the screen, the spare pixel is cropped
+  int width = (screen_width + scale - 1) / scale;
+  int height = (screen_height + scale - 1) / scale;
+  if (!PrepareWorldTarget(view, width, height, TEXTURE_FILTER_POINT)) {
+    view->pixel_perfect = false;
+    return camera;
+  }
+  view->offscreen = true;
+  view->scale = scale;
+
+  camera.target.x = roundf(camera.target.x / texel) * texel;
+  camera.target.y = roundf(camera.target.y / texel) * texel;
+  view->camera = (Camera2D) {
+    .offset = { width / 2, height / 2 },
+    .target = camera.target,
+    .zoom = 1.f / texel,
+  };
+  view->dest = (Rectangle) {
+    (screen_width - width * scale) / 2,
+    (screen_height - height * scale) / 2,
+    width * scale,
+    height * scale,
+  };
+
+  camera.offset = (Vector2) { view->dest.x + width / 2 * scale, view->dest.y + height / 2 * scale };
+  camera.zoom = scale / texel;
+  return camera;
+}
+
+Camera2D UpdateWorldView(WorldView *view, Camera2D camera) {
+  int screen_width = GetScreenWidth();
+  int screen_height = GetScreenHeight();
+  camera.offset = (Vector2) { screen_width / 2.f, screen_height / 2.f };
+  view->offscreen = false;
+  view->scale = 1;
+
+  if (view->pixel_perfect) {
+    Camera2D snapped = UpdatePixelPerfectView(view, camera, screen_width, screen_height);
+    if (view->offscreen) return snapped;
+  }
+  if (view->resolution <= 0.f || view->resolution >= 1.f) return camera;
+
+  int width = (int)(screen_width * view->resolution + 0.5f);
+  int height = (int)(screen_height * view->resolution + 0.5f);
+  if (width < 1 || height < 1 || !PrepareWorldTarget(view, width, height, TEXTURE_FILTER_BILINEAR)) {
+    return camera;
+  }
+  view->offscreen = true;
+
+  // The same view of the world, just fewer pixels across it
+  view->camera = (Camera2D) {
+    .offset = { width / 2.f, height / 2.f },
+    .target = camera.target,
+    .zoom = camera.zoom * width / screen_width,
+  };
+  view->dest = (Rectangle) { 0, 0, screen_width, screen_height };
+  return camera;
+}
+
+void BeginWorldView(const WorldView *view, Camera2D camera, Color background) {
+  if (view->offscreen) {
+    BeginTextureMode(view->target);
+    ClearBackground(background);
+    BeginMode2D(view->camera);
+  }
+  else {
+    BeginMode2D(camera);
+  }
+}
+
+void EndWorldView(const WorldView *view) {
+  EndMode2D();
+  if (!view->offscreen) return;
+
+  EndTextureMode();
+  // Render textures are stored bottom up
+  Texture2D texture = view->target.texture;
+  DrawTexturePro(texture, (Rectangle) { 0, 0, texture.width, -texture.height },
+      view->dest, (Vector2) { 0.0f, 0.0f }, 0.0f, WHITE);
+}
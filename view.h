@@ -0,0 +1,42 @@
+#ifndef VIEW_H_
+#define VIEW_H_
+
+#include "external/raylib-5.5/src/raylib.h"
+#include "game.h"
+#include <stdbool.h>
+
+#define ART_TILE_SIZE (16)  // texels per tile in the tile art
+
+// Where the world gets drawn. Straight to the screen, or, when pixel
+// perfect, into a small target at the art's own resolution (one texel, one
+// pixel) that is then blown up to the screen by a whole number as a single
+// quad. Texels all come out the same size and snap together, and the world
+// costs the fill rate of the small target rather than the screen.
+//
+// Otherwise resolution below 1 draws the world into a target that much
+// smaller than the screen and stretches it back up, filtered.
+typedef struct WorldView {
+  bool pixel_perfect;
+  float resolution;   // of the screen's, when not pixel perfect
+  RenderTexture2D target;
+  int filter;         // the target's texture filter
+  bool offscreen;     // drawing into target this frame
+  int scale;          // screen pixels per target pixel, when pixel perfect
+  Camera2D camera;    // draws into target
+  Rectangle dest;     // where target lands on screen
+} WorldView;
+
+void UnloadWorldView(WorldView *view);
+
+// Works out this frame's view from the game's camera (target and zoom) and
+// returns the camera that maps the screen onto the world, for picking and
+// culling. Pixel perfect views round the zoom to whole screen pixels per
+// texel and the target to whole texels. Zoomed out past one pixel per
+// texel they fall back to resolution like any other view.
+Camera2D UpdateWorldView(WorldView *view, Camera2D camera);
+
+// Drawing between these lands in the world, not on the screen
+void BeginWorldView(const WorldView *view, Camera2D camera, Color background);
+void EndWorldView(const WorldView *view);
+
+#endif // VIEW_H_
@@ -0,0 +1,72 @@
+#include "walkgrid.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const bool TileSolid[TEXTURE_TYPE_COUNT] = {
+  [EMPTY] = true,
+  [WATER] = true,
+  [HILL] = true,
+};
+
+static const bool ObjectSolid[OBJECT_TYPE_COUNT] = {
+  [OBJECT_FENCE] = true,
+  [OBJECT_CHEST] = true,
+  [OBJECT_TREE] = true,
+};
+
+bool InitWalkGrid(WalkGrid *grid, int width, int height) {
+  int stride = width + 2;
+  int chunks_x = (width + WALK_CHUNK_SIZE - 1) / WALK_CHUNK_SIZE;
+  int chunks_y = (height + WALK_CHUNK_SIZE - 1) / WALK_CHUNK_SIZE;
+
+  *grid = (WalkGrid) {
+    .width = width,
+    .height = height,
+    .stride = stride,
+    .solid = malloc((size_t)stride * (height + 2)),
+    .chunks_x = chunks_x,
+    .chunks_y = chunks_y,
+    .chunk_version = calloc((size_t)chunks_x * chunks_y, sizeof(unsigned int)),
+  };
+  if (!grid->solid || !grid->chunk_version) {
+    FreeWalkGrid(grid);
+    return false;
+  }
+
+  // Everything starts solid, the padding ring stays that way
+  memset(grid->solid, 1, (size_t)stride * (height + 2));
+  return true;
+}
+
+void FreeWalkGrid(WalkGrid *grid) {
+  free(grid->solid);
+  free(grid->chunk_version);
+  *grid = (WalkGrid) {0};
+}
+
+bool IsTileSolid(Tile tile) {
+  return TileSolid[tile.type] || ObjectSolid[tile.object];
+}
+
+void RebuildWalkGrid(WalkGrid *grid, Tile tile_map[][MAX_TILE_X]) {
+  for (int y = 0; y < grid->height && y < MAX_TILE_Y; y++) {
+    for (int x = 0; x < grid->width && x < MAX_TILE_X; x++) {
+      grid->solid[(y + 1) * grid->stride + (x + 1)] = IsTileSolid(tile_map[y][x]);
+    }
+  }
+  for (int i = 0; i < grid->chunks_x * grid->chunks_y; i++) {
+    grid->chunk_version[i]++;
+  }
+  grid->version++;
+}
+
+void SetCellSolid(WalkGrid *grid, int x, int y, bool solid) {
+  if (x < 0 || y < 0 || x >= grid->width || y >= grid->height) return;
+
+  unsigned char *cell = &grid->solid[(y + 1) * grid->stride + (x + 1)];
+  if (*cell == solid) return;
+
+  *cell = solid;
+  grid->chunk_version[GetChunkIndex(grid, x, y)]++;
+  grid->version++;
+}
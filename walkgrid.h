@@ -0,0 +1,41 @@
+#ifndef WALKGRID_H_
+#define WALKGRID_H_
+
+#include "game.h"
+#include <stdbool.h>
+
+#define WALK_CHUNK_SIZE (16)
+
+// Solid/walkable flag per tile, padded with a one cell solid border so
+// neighbour lookups never need a bounds check. Every change bumps the
+// version of the chunk it is in, which is what caches key on.
+typedef struct WalkGrid {
+  int width;
+  int height;
+  int stride;             // width + 2
+  unsigned char *solid;   // (width + 2) * (height + 2)
+
+  int chunks_x;
+  int chunks_y;
+  unsigned int *chunk_version;
+  unsigned int version;   // bumped on any change
+} WalkGrid;
+
+bool InitWalkGrid(WalkGrid *grid, int width, int height);
+void FreeWalkGrid(WalkGrid *grid);
+
+bool IsTileSolid(Tile tile);
+void RebuildWalkGrid(WalkGrid *grid, Tile tile_map[][MAX_TILE_X]);
+void SetCellSolid(WalkGrid *grid, int x, int y, bool solid);
+
+// Anything outside the map is solid
+static inline bool IsCellSolid(const WalkGrid *grid, int x, int y) {
+  if (x < -1 || y < -1 || x > grid->width || y > grid->height) return true;
+  return grid->solid[(y + 1) * grid->stride + (x + 1)];
+}
+
+static inline int GetChunkIndex(const WalkGrid *grid, int x, int y) {
+  return (y / WALK_CHUNK_SIZE) * grid->chunks_x + (x / WALK_CHUNK_SIZE);
+}
+
+#endif // WALKGRID_H_
@@ -0,0 +1,322 @@
+// The world has to come out the same for a seed whatever the build, so
+// a * b + c must not be fused into an FMA where the hardware has one
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+#include "worldgen.h"
+#include "jobs.h"
+#include <math.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE4_1__)
+#include <smmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Rows per job, one chunk strip
+#define WORLDGEN_GRAIN (16)
+
+#define HASH_X (0x27d4eb2du)
+#define HASH_Y (0x165667b1u)
+#define HASH_MIX (0x85ebca6bu)
+#define OCTAVE_SEED (0x9e3779b9u)
+
+// Feature sizes in tiles are roughly 1 / frequency
+#define ELEVATION_FREQUENCY (1.f / 48.f)
+#define MOISTURE_FREQUENCY (1.f / 32.f)
+#define FOREST_FREQUENCY (1.f / 24.f)
+
+#define WATER_LEVEL (0.36f)
+#define HILL_LEVEL (0.66f)
+#define DIRT_LEVEL (0.38f)
+#define FOREST_LEVEL (0.56f)
+#define TREE_CHANCE (0.4f)
+
+static inline unsigned int FinalizeHash(unsigned int h) {
+  h ^= h >> 15;
+  h *= HASH_MIX;
+  h ^= h >> 13;
+  return h;
+}
+
+static inline float HashToUnit(unsigned int h) {
+  return (float)(h >> 8) * (1.f / 16777216.f);
+}
+
+static float SampleNoiseScalar(unsigned int seed, float frequency, int octaves, int x, int y) {
+  float sum = 0.f;
+  float amplitude = 0.5f;
+  float total = 0.f;
+
+  for (int octave = 0; octave < octaves; octave++) {
+    float px = (float)x * frequency;
+    float py = (float)y * frequency;
+    float fx = floorf(px);
+    float fy = floorf(py);
+    unsigned int ix = (unsigned int)(int)fx;
+    unsigned int iy = (unsigned int)(int)fy;
+    float tx = px - fx;
+    float ty = py - fy;
+    float sx = tx * tx * (3.f - 2.f * tx);
+    float sy = ty * ty * (3.f - 2.f * ty);
+
+    unsigned int row0 = iy * HASH_Y ^ seed;
+    unsigned int row1 = (iy + 1) * HASH_Y ^ seed;
+    unsigned int col0 = ix * HASH_X;
+    unsigned int col1 = col0 + HASH_X;
+    float v00 = HashToUnit(FinalizeHash(col0 ^ row0));
+    float v10 = HashToUnit(FinalizeHash(col1 ^ row0));
+    float v01 = HashToUnit(FinalizeHash(col0 ^ row1));
+    float v11 = HashToUnit(FinalizeHash(col1 ^ row1));
+
+    float top = v00 + sx * (v10 - v00);
+    float bottom = v01 + sx * (v11 - v01);
+    sum += amplitude * (top + sy * (bottom - top));
+    total += amplitude;
+
+    frequency *= 2.f;
+    amplitude *= 0.5f;
+    seed += OCTAVE_SEED;
+  }
+  return sum / total;
+}
+
+#if defined(__AVX2__)
+static inline __m256i FinalizeHash8(__m256i h) {
+  h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 15));
+  h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int)HASH_MIX));
+  return _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+}
+
+static inline __m256 HashToUnit8(__m256i h) {
+  return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(h, 8)), _mm256_set1_ps(1.f / 16777216.f));
+}
+
+static int SampleNoiseSimd(unsigned int seed, float frequency, int octaves, int x, int y, int count, float *out) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 xs = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(x + i),
+          _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+    __m256 sum = _mm256_setzero_ps();
+    float freq = frequency;
+    float amplitude = 0.5f;
+    float total = 0.f;
+    unsigned int octave_seed = seed;
+
+    for (int octave = 0; octave < octaves; octave++) {
+      // The row is the same for every lane, so that half stays scalar
+      float py = (float)y * freq;
+      float fy = floorf(py);
+      unsigned int iy = (unsigned int)(int)fy;
+      float ty = py - fy;
+      float sy = ty * ty * (3.f - 2.f * ty);
+      __m256i row0 = _mm256_set1_epi32((int)(iy * HASH_Y ^ octave_seed));
+      __m256i row1 = _mm256_set1_epi32((int)((iy + 1) * HASH_Y ^ octave_seed));
+
+      __m256 px = _mm256_mul_ps(xs, _mm256_set1_ps(freq));
+      __m256 fx = _mm256_floor_ps(px);
+      __m256 tx = _mm256_sub_ps(px, fx);
+      __m256 sx = _mm256_mul_ps(_mm256_mul_ps(tx, tx),
+          _mm256_sub_ps(_mm256_set1_ps(3.f), _mm256_add_ps(tx, tx)));
+
+      __m256i col0 = _mm256_mullo_epi32(_mm256_cvttps_epi32(fx), _mm256_set1_epi32((int)HASH_X));
+      __m256i col1 = _mm256_add_epi32(col0, _mm256_set1_epi32((int)HASH_X));
+      __m256 v00 = HashToUnit8(FinalizeHash8(_mm256_xor_si256(col0, row0)));
+      __m256 v10 = HashToUnit8(FinalizeHash8(_mm256_xor_si256(col1, row0)));
+      __m256 v01 = HashToUnit8(FinalizeHash8(_mm256_xor_si256(col0, row1)));
+      __m256 v11 = HashToUnit8(FinalizeHash8(_mm256_xor_si256(col1, row1)));
+
+      __m256 top = _mm256_add_ps(v00, _mm256_mul_ps(sx, _mm256_sub_ps(v10, v00)));
+      __m256 bottom = _mm256_add_ps(v01, _mm256_mul_ps(sx, _mm256_sub_ps(v11, v01)));
+      __m256 value = _mm256_add_ps(top, _mm256_mul_ps(_mm256_set1_ps(sy), _mm256_sub_ps(bottom, top)));
+      sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(amplitude), value));
+      total += amplitude;
+
+      freq *= 2.f;
+      amplitude *= 0.5f;
+      octave_seed += OCTAVE_SEED;
+    }
+    _mm256_storeu_ps(&out[i], _mm256_div_ps(sum, _mm256_set1_ps(total)));
+  }
+  return i;
+}
+#elif defined(__SSE2__)
+#if defined(__SSE4_1__)
+#define MulLo32 _mm_mullo_epi32
+#define FloorPs _mm_floor_ps
+#else
+// SSE2 only multiplies the even lanes, so do the odd ones separately and
+// interleave the low halves back together
+static inline __m128i MulLo32(__m128i a, __m128i b) {
+  __m128i even = _mm_mul_epu32(a, b);
+  __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+      _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// Truncate, then step down where truncation rounded up
+static inline __m128 FloorPs(__m128 x) {
+  __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+  return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.f)));
+}
+#endif
+
+static inline __m128i FinalizeHash4(__m128i h) {
+  h = _mm_xor_si128(h, _mm_srli_epi32(h, 15));
+  h = MulLo32(h, _mm_set1_epi32((int)HASH_MIX));
+  return _mm_xor_si128(h, _mm_srli_epi32(h, 13));
+}
+
+static inline __m128 HashToUnit4(__m128i h) {
+  return _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(h, 8)), _mm_set1_ps(1.f / 16777216.f));
+}
+
+static int SampleNoiseSimd(unsigned int seed, float frequency, int octaves, int x, int y, int count, float *out) {
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 xs = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32(x + i), _mm_setr_epi32(0, 1, 2, 3)));
+    __m128 sum = _mm_setzero_ps();
+    float freq = frequency;
+    float amplitude = 0.5f;
+    float total = 0.f;
+    unsigned int octave_seed = seed;
+
+    for (int octave = 0; octave < octaves; octave++) {
+      // The row is the same for every lane, so that half stays scalar
+      float py = (float)y * freq;
+      float fy = floorf(py);
+      unsigned int iy = (unsigned int)(int)fy;
+      float ty = py - fy;
+      float sy = ty * ty * (3.f - 2.f * ty);
+      __m128i row0 = _mm_set1_epi32((int)(iy * HASH_Y ^ octave_seed));
+      __m128i row1 = _mm_set1_epi32((int)((iy + 1) * HASH_Y ^ octave_seed));
+
+      __m128 px = _mm_mul_ps(xs, _mm_set1_ps(freq));
+      __m128 fx = FloorPs(px);
+      __m128 tx = _mm_sub_ps(px, fx);
+      __m128 sx = _mm_mul_ps(_mm_mul_ps(tx, tx), _mm_sub_ps(_mm_set1_ps(3.f), _mm_add_ps(tx, tx)));
+
+      __m128i col0 = MulLo32(_mm_cvttps_epi32(fx), _mm_set1_epi32((int)HASH_X));
+      __m128i col1 = _mm_add_epi32(col0, _mm_set1_epi32((int)HASH_X));
+      __m128 v00 = HashToUnit4(FinalizeHash4(_mm_xor_si128(col0, row0)));
+      __m128 v10 = HashToUnit4(FinalizeHash4(_mm_xor_si128(col1, row0)));
+      __m128 v01 = HashToUnit4(FinalizeHash4(_mm_xor_si128(col0, row1)));
+      __m128 v11 = HashToUnit4(FinalizeHash4(_mm_xor_si128(col1, row1)));
+
+      __m128 top = _mm_add_ps(v00, _mm_mul_ps(sx, _mm_sub_ps(v10, v00)));
+      __m128 bottom = _mm_add_ps(v01, _mm_mul_ps(sx, _mm_sub_ps(v11, v01)));
+      __m128 value = _mm_add_ps(top, _mm_mul_ps(_mm_set1_ps(sy), _mm_sub_ps(bottom, top)));
+      sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(amplitude), value));
+      total += amplitude;
+
+      freq *= 2.f;
+      amplitude *= 0.5f;
+      octave_seed += OCTAVE_SEED;
+    }
+    _mm_storeu_ps(&out[i], _mm_div_ps(sum, _mm_set1_ps(total)));
+  }
+  return i;
+}
+#else
+static int SampleNoiseSimd(unsigned int seed, float frequency, int octaves, int x, int y, int count, float *out) {
+  (void)seed;
+  (void)frequency;
+  (void)octaves;
+  (void)x;
+  (void)y;
+  (void)count;
+  (void)out;
+  return 0;
+}
+#endif
+
+void SampleNoiseRow(unsigned int seed, float frequency, int octaves, int x, int y, int count, float *out) {
+  // Full vector batches first, the remainder goes through the scalar path
+  int done = SampleNoiseSimd(seed, frequency, octaves, x, y, count, out);
+  for (int i = done; i < count; i++) {
+    out[i] = SampleNoiseScalar(seed, frequency, octaves, x + i, y);
+  }
+}
+
+// 0 inside the clearing, rising to 1 at clearing_margin tiles away from it
+static float ClearingFalloff(const WorldGenDesc *desc, int x, int y) {
+  if (desc->clearing_width <= 0 || desc->clearing_height <= 0) return 1.f;
+
+  int x1 = desc->clearing_x + desc->clearing_width - 1;
+  int y1 = desc->clearing_y + desc->clearing_height - 1;
+  int dx = x < desc->clearing_x ? desc->clearing_x - x : x > x1 ? x - x1 : 0;
+  int dy = y < desc->clearing_y ? desc->clearing_y - y : y > y1 ? y - y1 : 0;
+  int distance = dx > dy ? dx : dy;
+
+  if (distance >= desc->clearing_margin) return 1.f;
+  return (float)distance / (float)desc->clearing_margin;
+}
+
+typedef struct {
+  Tile *tiles;
+  const WorldGenDesc *desc;
+  atomic_bool failed;
+} WorldGenJob;
+
+static void GenerateRows(void *ctx, int begin, int end) {
+  WorldGenJob *job = ctx;
+  const WorldGenDesc *desc = job->desc;
+  int width = desc->width;
+
+  float *elevation = malloc(3 * (size_t)width * sizeof(float));
+  if (!elevation) {
+    atomic_store(&job->failed, true);
+    return;
+  }
+  float *moisture = elevation + width;
+  float *forest = moisture + width;
+
+  unsigned int seed = desc->seed;
+  unsigned int tree_seed = FinalizeHash(seed ^ 0x5bd1e995u);
+
+  for (int y = begin; y < end; y++) {
+    SampleNoiseRow(seed, ELEVATION_FREQUENCY, 5, 0, y, width, elevation);
+    SampleNoiseRow(FinalizeHash(seed + 1), MOISTURE_FREQUENCY, 4, 0, y, width, moisture);
+    SampleNoiseRow(FinalizeHash(seed + 2), FOREST_FREQUENCY, 3, 0, y, width, forest);
+
+    Tile *row = &job->tiles[(size_t)y * width];
+    for (int x = 0; x < width; x++) {
+      float t = ClearingFalloff(desc, x, y);
+      float e = 0.5f + (elevation[x] - 0.5f) * t;
+      float m = 1.f + (moisture[x] - 1.f) * t;
+      float f = forest[x] * t;
+
+      TextureType type = GRASS;
+      if (e < WATER_LEVEL) type = WATER;
+      else if (e > HILL_LEVEL) type = HILL;
+      else if (m < DIRT_LEVEL) type = DIRT;
+
+      ObjectType object = OBJECT_NONE;
+      if (type == GRASS && f > FOREST_LEVEL) {
+        unsigned int h = FinalizeHash((unsigned int)x * HASH_X ^ ((unsigned int)y * HASH_Y ^ tree_seed));
+        if (HashToUnit(h) < TREE_CHANCE) object = OBJECT_TREE;
+      }
+
+      row[x] = (Tile) {
+        .posX = x * TILE_SIZE,
+        .posY = y * TILE_SIZE,
+        .type = type,
+        .object = object,
+      };
+    }
+  }
+  free(elevation);
+}
+
+bool GenerateWorld(Tile *tiles, WorldGenDesc desc) {
+  WorldGenJob job = { tiles, &desc, false };
+  ParallelFor(0, desc.height, WORLDGEN_GRAIN, GenerateRows, &job);
+  return !atomic_load(&job.failed);
+}
@@ -0,0 +1,36 @@
+#ifndef WORLDGEN_H_
+#define WORLDGEN_H_
+
+#include "game.h"
+#include <stdbool.h>
+
+#if defined(__AVX2__)
+#define NOISE_SIMD_WIDTH (8)
+#elif defined(__SSE2__)
+#define NOISE_SIMD_WIDTH (4)
+#else
+#define NOISE_SIMD_WIDTH (1)
+#endif
+
+typedef struct WorldGenDesc {
+  unsigned int seed;
+  int width;
+  int height;
+
+  // Kept as open grass so the farm always has room, with the terrain easing
+  // back in over clearing_margin tiles around it
+  int clearing_x;
+  int clearing_y;
+  int clearing_width;
+  int clearing_height;
+  int clearing_margin;
+} WorldGenDesc;
+
+// Fills tiles (width * height, row-major) with grass, dirt, water, hills and
+// trees. Rows are generated in parallel; the result only depends on desc.
+bool GenerateWorld(Tile *tiles, WorldGenDesc desc);
+
+// Fractal value noise in [0, 1) for count tiles starting at (x, y)
+void SampleNoiseRow(unsigned int seed, float frequency, int octaves, int x, int y, int count, float *out);
+
+#endif // WORLDGEN_H_